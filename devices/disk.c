@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -71,7 +72,8 @@ struct channel {
 	struct lock lock;           /* Must acquire to access the controller. */
 	bool expecting_interrupt;   /* True if an interrupt is expected, false if
 								   any interrupt would be spurious. */
-	struct semaphore completion_wait;   /* Up'd by interrupt handler. */
+	struct semaphore completion_wait;   /* Up'd by completion_softirq. */
+	struct softirq completion_softirq;  /* Raised by interrupt handler. */
 
 	struct disk devices[2];     /* The devices on this channel. */
 };
@@ -95,6 +97,8 @@ static void select_device (const struct disk *);
 static void select_device_wait (const struct disk *);
 
 static void interrupt_handler (struct intr_frame *);
+static softirq_func wake_waiter;
+static int disk_id (const struct disk *);
 
 /* Initialize the disk subsystem and detect disks. */
 void
@@ -119,9 +123,10 @@ disk_init (void) {
 			default:
 				NOT_REACHED ();
 		}
-		lock_init (&c->lock);
+		lock_init_named (&c->lock, c->name);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
+		softirq_init (&c->completion_softirq, wake_waiter, c);
 
 		/* Initialize devices. */
 		for (dev_no = 0; dev_no < 2; dev_no++) {
@@ -203,6 +208,13 @@ disk_size (struct disk *d) {
 	return d->capacity;
 }
 
+/* Returns a number identifying disk D in traces:
+   2 * CHAN_NO + DEV_NO, as in the disk_get() arguments. */
+static int
+disk_id (const struct disk *d) {
+	return (d->channel - channels) * 2 + d->dev_no;
+}
+
 /* Reads sector SEC_NO from disk D into BUFFER, which must have
    room for DISK_SECTOR_SIZE bytes.
    Internally synchronizes accesses to disks, so external
@@ -216,6 +228,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 
 	c = d->channel;
 	lock_acquire (&c->lock);
+	trace_event (TRACE_DISK_READ, sec_no, disk_id (d));
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
 	sema_down (&c->completion_wait);
@@ -223,6 +236,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
 	d->read_cnt++;
+	trace_event (TRACE_DISK_DONE, sec_no, disk_id (d));
 	lock_release (&c->lock);
 }
 
@@ -240,6 +254,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 
 	c = d->channel;
 	lock_acquire (&c->lock);
+	trace_event (TRACE_DISK_WRITE, sec_no, disk_id (d));
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
 	if (!wait_while_busy (d))
@@ -247,6 +262,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
 	d->write_cnt++;
+	trace_event (TRACE_DISK_DONE, sec_no, disk_id (d));
 	lock_release (&c->lock);
 }
 
@@ -520,7 +536,7 @@ interrupt_handler (struct intr_frame *f) {
 		if (f->vec_no == c->irq) {
 			if (c->expecting_interrupt) {
 				inb (reg_status (c));               /* Acknowledge interrupt. */
-				sema_up (&c->completion_wait);      /* Wake up waiter. */
+				softirq_raise (&c->completion_softirq); /* Wake up waiter. */
 			} else
 				printf ("%s: unexpected interrupt\n", c->name);
 			return;
@@ -529,6 +545,14 @@ interrupt_handler (struct intr_frame *f) {
 	NOT_REACHED ();
 }
 
+/* Wakes up the thread waiting for channel C_'s command to
+   complete.  Runs as a softirq raised by interrupt_handler(). */
+static void
+wake_waiter (void *c_) {
+	struct channel *c = c_;
+	sema_up (&c->completion_wait);
+}
+
 static void
 inspect_read_cnt (struct intr_frame *f) {
 	struct disk * d = disk_get (f->R.rdx, f->R.rcx);
@@ -0,0 +1,122 @@
+#include "devices/lapic.h"
+#include <debug.h>
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Local APIC.  Pintos still takes device interrupts through the
+   8259A PICs, which reach the CPU through the local APIC's LINT0
+   pin in "virtual wire" mode; we use the local APIC only for its
+   timer.  See [IA32-v3a] chapter 10 "Advanced Programmable
+   Interrupt Controller (APIC)". */
+
+#define CPUID_1_EDX_APIC (1 << 9)       /* CPU has a local APIC. */
+#define MSR_APIC_BASE 0x1b              /* Base address MSR. */
+#define APIC_BASE_ENABLE (1 << 11)      /* Globally enabled. */
+#define APIC_BASE_ADDR 0xffffff000ULL   /* Physical address bits. */
+
+/* Register offsets. */
+#define REG_ID 0x020                    /* Local APIC ID. */
+#define REG_EOI 0x0b0                   /* End of interrupt. */
+#define REG_SVR 0x0f0                   /* Spurious interrupt vector. */
+#define REG_LVT_TIMER 0x320             /* Timer local vector. */
+#define REG_LVT_LINT0 0x350             /* LINT0 local vector. */
+#define REG_LVT_LINT1 0x360             /* LINT1 local vector. */
+#define REG_TIMER_INIT 0x380            /* Timer initial count. */
+#define REG_TIMER_CUR 0x390             /* Timer current count. */
+#define REG_TIMER_DIV 0x3e0             /* Timer divide configuration. */
+
+#define SVR_ENABLE 0x100                /* Software enable. */
+#define LVT_MASKED (1 << 16)            /* Interrupt masked. */
+#define LVT_NMI 0x400                   /* Deliver as NMI. */
+#define LVT_EXTINT 0x700                /* Deliver from the 8259A. */
+#define TIMER_DIV_16 0x3                /* Count at bus clock / 16. */
+
+#define SPURIOUS_VEC 0xff
+
+/* Registers, mapped uncached, or null if not set up. */
+static volatile uint32_t *regs;
+
+static intr_handler_func spurious_interrupt;
+
+static uint32_t
+lapic_read (int reg) {
+	return regs[reg / 4];
+}
+
+static void
+lapic_write (int reg, uint32_t value) {
+	regs[reg / 4] = value;
+	lapic_read (REG_ID);    /* Wait for the write to finish. */
+}
+
+/* Maps and enables the local APIC, with its timer idle.  Returns
+   false, leaving everything alone, if the CPU has no enabled
+   local APIC. */
+bool
+lapic_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t base, *pte;
+
+	__asm __volatile ("cpuid"
+			: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+	if (!(edx & CPUID_1_EDX_APIC))
+		return false;
+	base = read_msr (MSR_APIC_BASE);
+	if (!(base & APIC_BASE_ENABLE))
+		return false;
+	base &= APIC_BASE_ADDR;
+
+	/* The registers lie above RAM, so paging_init() did not map
+	   them.  Kernel mappings are shared by every page table, so
+	   mapping them in base_pml4 suffices. */
+	pte = pml4e_walk (base_pml4, (uint64_t) ptov (base), 1);
+	if (pte == NULL)
+		return false;
+	*pte = base | PTE_P | PTE_W | PTE_PWT | PTE_PCD;
+	regs = ptov (base);
+
+	intr_register_int (SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+			"APIC Spurious");
+	lapic_write (REG_LVT_LINT0, LVT_EXTINT);
+	lapic_write (REG_LVT_LINT1, LVT_NMI);
+	lapic_write (REG_LVT_TIMER, LVT_MASKED | LAPIC_TIMER_VEC);
+	lapic_write (REG_TIMER_DIV, TIMER_DIV_16);
+	lapic_write (REG_TIMER_INIT, 0);
+	lapic_write (REG_SVR, SVR_ENABLE | SPURIOUS_VEC);
+	lapic_write (REG_LVT_TIMER, LAPIC_TIMER_VEC);
+	lapic_eoi ();
+	return true;
+}
+
+/* Acknowledges the interrupt being handled. */
+void
+lapic_eoi (void) {
+	ASSERT (regs != NULL);
+	lapic_write (REG_EOI, 0);
+}
+
+/* Interrupts once after COUNT timer counts, or stops the timer
+   if COUNT is 0.  The timer counts at the bus clock divided by
+   16. */
+void
+lapic_timer_start (uint32_t count) {
+	ASSERT (regs != NULL);
+	lapic_write (REG_TIMER_INIT, count);
+}
+
+/* Returns the counts left before the timer interrupts. */
+uint32_t
+lapic_timer_remaining (void) {
+	ASSERT (regs != NULL);
+	return lapic_read (REG_TIMER_CUR);
+}
+
+/* Spurious interrupts need no acknowledgement.  See [IA32-v3a]
+   10.9 "Spurious Interrupt". */
+static void
+spurious_interrupt (struct intr_frame *f UNUSED) {
+}
@@ -1,7 +1,8 @@
 #include "devices/serial.h"
 #include <debug.h>
+#include <stdio.h>
+#include <string.h>
 #include "devices/input.h"
-#include "devices/intq.h"
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
@@ -37,6 +38,15 @@
 #define IER_RECV 0x01           /* Interrupt when data received. */
 #define IER_XMIT 0x02           /* Interrupt when transmit finishes. */
 
+/* FIFO Control Register bits. */
+#define FCR_ENABLE 0x01         /* Enable receive and transmit FIFOs. */
+#define FCR_RX_RESET 0x02       /* Clear receive FIFO. */
+#define FCR_TX_RESET 0x04       /* Clear transmit FIFO. */
+#define FCR_TRIG_14 0xc0        /* Receive interrupt at 14 bytes. */
+
+/* Depth of the 16550A transmit FIFO, in bytes. */
+#define TX_FIFO_SIZE 16
+
 /* Line Control Register bits. */
 #define LCR_N81 0x03            /* No parity, 8 data bits, 1 stop bit. */
 #define LCR_DLAB 0x80           /* Divisor Latch Access Bit (DLAB). */
@@ -46,17 +56,38 @@
 
 /* Line Status Register. */
 #define LSR_DR 0x01             /* Data Ready: received data byte is in RBR. */
-#define LSR_THRE 0x20           /* THR Empty. */
+#define LSR_THRE 0x20           /* THR Empty (TX FIFO empty in FIFO mode). */
+#define LSR_TEMT 0x40           /* Transmitter completely idle. */
 
 /* Transmission mode. */
 static enum { UNINIT, POLL, QUEUE } mode;
 
-/* Data to be transmitted. */
-static struct intq txq;
+/* Statistics. */
+static int serial_bps;          /* Current line speed. */
+static long long intr_cnt;      /* # of serial interrupts. */
+static long long poll_cnt;      /* # of bytes polled out in QUEUE mode. */
+
+/* Transmit queue size, in bytes.  Must be a power of 2.
+   Large enough that a typical write() to the console is queued
+   in one go and drained by the interrupt handler while the
+   writer goes on with its work. */
+#define TXQ_SIZE 4096
+
+/* Data to be transmitted.  TXQ_HEAD and TXQ_TAIL count bytes
+   ever added and removed; only their difference matters.
+   Accessed only with interrupts off. */
+static uint8_t txq[TXQ_SIZE];
+static size_t txq_head, txq_tail;
+static struct lock txq_lock;          /* Only one thread may wait. */
+static struct thread *txq_waiter;     /* Thread waiting for room. */
 
 static void set_serial (int bps);
 static void putc_poll (uint8_t);
 static void write_ier (void);
+static bool txq_empty (void);
+static bool txq_full (void);
+static uint8_t txq_getc (void);
+static void txq_wait (void);
 static intr_handler_func serial_interrupt;
 
 /* Initializes the serial port device for polling mode.
@@ -67,10 +98,11 @@ static void
 init_poll (void) {
 	ASSERT (mode == UNINIT);
 	outb (IER_REG, 0);                    /* Turn off all interrupts. */
-	outb (FCR_REG, 0);                    /* Disable FIFO. */
+	outb (FCR_REG, FCR_ENABLE | FCR_RX_RESET | FCR_TX_RESET
+			| FCR_TRIG_14);                   /* Enable and clear FIFOs. */
 	set_serial (115200);                  /* 115.2 kbps, N-8-1. */
 	outb (MCR_REG, MCR_OUT2);             /* Required to enable interrupts. */
-	intq_init (&txq);
+	lock_init (&txq_lock);
 	mode = POLL;
 }
 
@@ -92,6 +124,52 @@ serial_init_queue (void) {
 	intr_set_level (old_level);
 }
 
+/* Changes the line speed to BPS bits per second, which must be
+   between 300 and 115200.  Used for the "-baud" kernel
+   command-line option. */
+void
+serial_set_bps (int bps) {
+	enum intr_level old_level = intr_disable ();
+
+	if (mode == UNINIT)
+		init_poll ();
+
+	/* Let the byte in the shift register go out at the old
+	   speed. */
+	serial_flush ();
+	while ((inb (LSR_REG) & LSR_TEMT) == 0)
+		continue;
+	set_serial (bps);
+
+	intr_set_level (old_level);
+}
+
+/* Returns the number of bytes waiting in the transmit queue. */
+size_t
+serial_queued (void) {
+	enum intr_level old_level = intr_disable ();
+	size_t cnt = txq_head - txq_tail;
+	intr_set_level (old_level);
+	return cnt;
+}
+
+/* Returns the number of bytes sent by polling, rather than by the
+   interrupt handler, since the transmit queue was set up. */
+long long
+serial_polled (void) {
+	enum intr_level old_level = intr_disable ();
+	long long cnt = poll_cnt;
+	intr_set_level (old_level);
+	return cnt;
+}
+
+/* Prints serial port statistics. */
+void
+serial_print_stats (void) {
+	printf ("Serial: %d bps, %lld interrupts, %lld bytes polled\n",
+			serial_bps, intr_cnt, poll_cnt);
+}
+
 /* Sends BYTE to the serial port. */
 void
 serial_putc (uint8_t byte) {
@@ -106,29 +184,76 @@ serial_putc (uint8_t byte) {
 	} else {
 		/* Otherwise, queue a byte and update the interrupt enable
 		   register. */
-		if (old_level == INTR_OFF && intq_full (&txq)) {
-			/* Interrupts are off and the transmit queue is full.
-			   If we wanted to wait for the queue to empty,
-			   we'd have to reenable interrupts.
-			   That's impolite, so we'll send a character via
-			   polling instead. */
-			putc_poll (intq_getc (&txq));
+		if (txq_full ()) {
+			/* If interrupts are off and the transmit queue is
+			   full, waiting for the queue to empty would mean
+			   reenabling interrupts.  That's impolite, so we
+			   send a character via polling instead.  Otherwise
+			   we sleep until the interrupt handler makes room. */
+			if (old_level == INTR_OFF)
+				putc_poll (txq_getc ());
+			else
+				txq_wait ();
 		}
 
-		intq_putc (&txq, byte);
+		txq[txq_head++ % TXQ_SIZE] = byte;
 		write_ier ();
 	}
 
 	intr_set_level (old_level);
 }
 
+/* Sends the N bytes in BUFFER to the serial port.
+   Equivalent to calling serial_putc() on each byte, but copies
+   as many bytes as fit into the transmit queue at a time and
+   reprograms the UART only once per block. */
+void
+serial_putbuf (const uint8_t *buffer, size_t n) {
+	enum intr_level old_level = intr_disable ();
+
+	if (mode != QUEUE) {
+		if (mode == UNINIT)
+			init_poll ();
+		while (n-- > 0)
+			putc_poll (*buffer++);
+	} else {
+		while (n > 0) {
+			size_t ofs = txq_head % TXQ_SIZE;
+			size_t room = TXQ_SIZE - (txq_head - txq_tail);
+			size_t chunk;
+
+			if (room == 0) {
+				/* See serial_putc(). */
+				if (old_level == INTR_OFF)
+					putc_poll (txq_getc ());
+				else
+					txq_wait ();
+				continue;
+			}
+
+			/* Copy up to the end of the buffer; a wrapped block goes
+			   in on the next iteration. */
+			chunk = n < room ? n : room;
+			if (chunk > TXQ_SIZE - ofs)
+				chunk = TXQ_SIZE - ofs;
+			memcpy (txq + ofs, buffer, chunk);
+			txq_head += chunk;
+			buffer += chunk;
+			n -= chunk;
+			write_ier ();
+		}
+	}
+
+	intr_set_level (old_level);
+}
+
 /* Flushes anything in the serial buffer out the port in polling
    mode. */
 void
 serial_flush (void) {
 	enum intr_level old_level = intr_disable ();
-	while (!intq_empty (&txq))
-		putc_poll (intq_getc (&txq));
+	while (!txq_empty ())
+		putc_poll (txq_getc ());
 	intr_set_level (old_level);
 }
 
@@ -160,6 +285,8 @@ set_serial (int bps) {
 
 	/* Reset DLAB. */
 	outb (LCR_REG, LCR_N81);
+
+	serial_bps = bps;
 }
 
 /* Update interrupt enable register. */
@@ -171,7 +298,7 @@ write_ier (void) {
 
 	/* Enable transmit interrupt if we have any characters to
 	   transmit. */
-	if (!intq_empty (&txq))
+	if (!txq_empty ())
 		ier |= IER_XMIT;
 
 	/* Enable receive interrupt if we have room to store any
@@ -188,6 +315,9 @@ static void
 putc_poll (uint8_t byte) {
 	ASSERT (intr_get_level () == INTR_OFF);
 
+	if (mode == QUEUE)
+		poll_cnt++;
+
 	while ((inb (LSR_REG) & LSR_THRE) == 0)
 		continue;
 	outb (THR_REG, byte);
@@ -199,17 +329,70 @@ serial_interrupt (struct intr_frame *f UNUSED) {
 	/* Inquire about interrupt in UART.  Without this, we can
 	   occasionally miss an interrupt running under QEMU. */
 	inb (IIR_REG);
+	intr_cnt++;
 
 	/* As long as we have room to receive a byte, and the hardware
-	   has a byte for us, receive a byte.  */
+	   has a byte for us, receive a byte.  With the receive FIFO
+	   enabled this drains up to a whole FIFO's worth per
+	   interrupt. */
 	while (!input_full () && (inb (LSR_REG) & LSR_DR) != 0)
 		input_putc (inb (RBR_REG));
 
-	/* As long as we have a byte to transmit, and the hardware is
-	   ready to accept a byte for transmission, transmit a byte. */
-	while (!intq_empty (&txq) && (inb (LSR_REG) & LSR_THRE) != 0)
-		outb (THR_REG, intq_getc (&txq));
+	/* THRE means the whole transmit FIFO is empty, so once it is
+	   set we may write a full FIFO's worth of bytes without
+	   polling the line status register in between. */
+	if ((inb (LSR_REG) & LSR_THRE) != 0) {
+		int i;
+
+		for (i = 0; i < TX_FIFO_SIZE && !txq_empty (); i++)
+			outb (THR_REG, txq_getc ());
+	}
 
 	/* Update interrupt enable register based on queue status. */
 	write_ier ();
 }
+
+/* Returns true if the transmit queue is empty. */
+static bool
+txq_empty (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return txq_head == txq_tail;
+}
+
+/* Returns true if the transmit queue is full. */
+static bool
+txq_full (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return txq_head - txq_tail == TXQ_SIZE;
+}
+
+/* Removes a byte from the transmit queue, which must not be
+   empty, and returns it.  Wakes up a thread waiting for room. */
+static uint8_t
+txq_getc (void) {
+	uint8_t byte;
+
+	ASSERT (!txq_empty ());
+	byte = txq[txq_tail++ % TXQ_SIZE];
+	if (txq_waiter != NULL) {
+		thread_unblock (txq_waiter);
+		txq_waiter = NULL;
+	}
+	return byte;
+}
+
+/* Sleeps until the transmit queue has room for at least one
+   byte.  Must be called with interrupts off, from a thread that
+   had them on. */
+static void
+txq_wait (void) {
+	ASSERT (!intr_context ());
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lock_acquire (&txq_lock);
+	while (txq_full ()) {
+		txq_waiter = thread_current ();
+		thread_block ();
+	}
+	lock_release (&txq_lock);
+}
@@ -3,10 +3,12 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "devices/lapic.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -19,15 +21,51 @@
 
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
+static struct seqlock ticks_seqlock;    /* Protects `ticks'. */
 
-/* Number of loops per timer tick.
+/* Wakes sleeping threads whose time has come. */
+static struct softirq wakeup_softirq;
+
+/* 8254 input frequency, in Hz. */
+#define PIT_HZ 1193182
+
+#define NSEC_PER_SEC 1000000000LL
+
+/* Sleeps shorter than this many nanoseconds spin on the TSC,
+   since blocking and waking up again would take longer. */
+#define SPIN_NS 20000
+
+/* TSC cycles per second, and the TSC at timer_init().
    Initialized by timer_calibrate(). */
-static unsigned loops_per_tick;
+static uint64_t tsc_hz;
+static uint64_t tsc_boot;
+
+/* Local APIC timer counts per second, or 0 if sub-tick sleeps
+   can't use the local APIC timer.  Initialized by
+   timer_use_lapic(). */
+static uint64_t lapic_hz;
+
+/* A thread in timer_msleep(), timer_usleep() or timer_nsleep(). */
+struct deadline_sleeper {
+	int64_t deadline;               /* timer_ns() to wake up at. */
+	struct semaphore sema;          /* Up'd at the deadline. */
+	struct list_elem elem;          /* deadline_sleepers element. */
+};
+
+/* Sleepers ordered by deadline.  The local APIC timer is armed
+   for the first one. */
+static struct list deadline_sleepers;
+static struct softirq deadline_softirq;
 
 static intr_handler_func timer_interrupt;
-static bool too_many_loops (unsigned loops);
-static void busy_wait (int64_t loops);
+static intr_handler_func lapic_timer_interrupt;
+static softirq_func wake_sleepers;
+static softirq_func wake_deadline_sleepers;
 static void real_time_sleep (int64_t num, int32_t denom);
+static void deadline_sleep (int64_t ns);
+static void spin (int64_t ns);
+static void arm_lapic (int64_t ns);
+static int64_t cycles_to_ns (uint64_t cycles, uint64_t hz);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -38,6 +76,11 @@ timer_init (void) {
 	   nearest. */
 	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
 
+	tsc_boot = rdtsc ();
+	seqlock_init (&ticks_seqlock);
+	softirq_init (&wakeup_softirq, wake_sleepers, NULL);
+	list_init (&deadline_sleepers);
+	softirq_init (&deadline_softirq, wake_deadline_sleepers, NULL);
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
@@ -45,38 +88,83 @@ timer_init (void) {
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
-/* Calibrates loops_per_tick, used to implement brief delays. */
+/* Calibrates the TSC against the 8254's counter 2, which we
+   otherwise leave unused: counting down from 10 ms worth of PIT
+   input clocks in mode 0 raises its output when done. */
 void
 timer_calibrate (void) {
-	unsigned high_bit, test_bit;
+	uint16_t count = PIT_HZ / 100;
+	enum intr_level old_level;
+	uint64_t start;
 
 	ASSERT (intr_get_level () == INTR_ON);
 	printf ("Calibrating timer...  ");
 
-	/* Approximate loops_per_tick as the largest power-of-two
-	   still less than one timer tick. */
-	loops_per_tick = 1u << 10;
-	while (!too_many_loops (loops_per_tick << 1)) {
-		loops_per_tick <<= 1;
-		ASSERT (loops_per_tick != 0);
-	}
+	old_level = intr_disable ();
+	outb (0x61, (inb (0x61) & ~0x02) | 0x01);   /* Gate on, speaker off. */
+	outb (0x43, 0xb0);    /* CW: counter 2, LSB then MSB, mode 0, binary. */
+	outb (0x42, count & 0xff);
+	outb (0x42, count >> 8);
+	start = rdtsc ();
+	while (!(inb (0x61) & 0x20))
+		continue;
+	tsc_hz = (rdtsc () - start) * 100;
+	intr_set_level (old_level);
 
-	/* Refine the next 8 bits of loops_per_tick. */
-	high_bit = loops_per_tick;
-	for (test_bit = high_bit >> 1; test_bit != high_bit >> 10; test_bit >>= 1)
-		if (!too_many_loops (high_bit | test_bit))
-			loops_per_tick |= test_bit;
+	printf ("%'"PRIu64" TSC cycles/s.\n", tsc_hz);
+}
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+/* Uses the local APIC timer, if there is one, to wake threads
+   from sub-tick sleeps.  Must be called after
+   timer_calibrate(). */
+void
+timer_use_lapic (void) {
+	enum intr_level old_level;
+	uint64_t start;
+
+	ASSERT (tsc_hz != 0);
+	if (!lapic_init ())
+		return;
+	intr_register_ext (LAPIC_TIMER_VEC, lapic_timer_interrupt, "APIC Timer");
+
+	/* Count for 1 ms of TSC cycles. */
+	old_level = intr_disable ();
+	lapic_timer_start (UINT32_MAX);
+	start = rdtsc ();
+	while (rdtsc () - start < tsc_hz / 1000)
+		continue;
+	lapic_hz = (uint64_t) (UINT32_MAX - lapic_timer_remaining ()) * 1000;
+	lapic_timer_start (0);
+	intr_set_level (old_level);
+
+	printf ("Local APIC timer: %'"PRIu64" counts/s.\n", lapic_hz);
+}
+
+/* Returns the TSC frequency in Hz, or 0 before
+   timer_calibrate(). */
+uint64_t
+timer_tsc_hz (void) {
+	return tsc_hz;
+}
+
+/* Returns the number of nanoseconds since the OS booted. */
+int64_t
+timer_ns (void) {
+	if (tsc_hz == 0)
+		return timer_ticks () * (NSEC_PER_SEC / TIMER_FREQ);
+	return cycles_to_ns (rdtsc () - tsc_boot, tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
 int64_t
 timer_ticks (void) {
-	enum intr_level old_level = intr_disable ();
-	int64_t t = ticks;
-	intr_set_level (old_level);
-	barrier ();
+	int64_t t;
+	unsigned seq;
+
+	do {
+		seq = seqlock_read_begin (&ticks_seqlock);
+		t = ticks;
+	} while (seqlock_read_retry (&ticks_seqlock, seq));
 	return t;
 }
 
@@ -122,75 +210,142 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	printf ("Timer: %"PRId64" ticks, %"PRId64" ns\n", timer_ticks (),
+			timer_ns ());
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED) {
+	seqlock_write_begin (&ticks_seqlock);
 	ticks++;
+	seqlock_write_end (&ticks_seqlock);
 	thread_tick ();
 
 	int64_t cur_min_time = get_min_time();
 
 	if (ticks >= cur_min_time) {
-		thread_awake(ticks);
+		softirq_raise (&wakeup_softirq);
 	}
 }
 
-/* Returns true if LOOPS iterations waits for more than one timer
-   tick, otherwise false. */
+/* Wakes up the threads whose sleep has expired.  Runs as a
+   softirq, because the sleep list can be long. */
+static void
+wake_sleepers (void *aux UNUSED) {
+	thread_awake (timer_ticks ());
+}
+
+/* Interrupt handler for the local APIC timer. */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) {
+	softirq_raise (&deadline_softirq);
+}
+
+/* Wakes up the deadline sleepers whose time has come and arms
+   the local APIC timer for the next one.  Runs as a softirq.
+   deadline_sleepers is otherwise only touched with interrupts
+   off, by threads, so it cannot change under us. */
+static void
+wake_deadline_sleepers (void *aux UNUSED) {
+	int64_t now = timer_ns ();
+
+	while (!list_empty (&deadline_sleepers)) {
+		struct deadline_sleeper *s = list_entry (list_front (&deadline_sleepers),
+				struct deadline_sleeper, elem);
+		if (s->deadline > now) {
+			arm_lapic (s->deadline - now);
+			break;
+		}
+		list_pop_front (&deadline_sleepers);
+		sema_up (&s->sema);
+	}
+}
+
+/* Returns true if deadline sleeper A wakes up before B. */
 static bool
-too_many_loops (unsigned loops) {
-	/* Wait for a timer tick. */
-	int64_t start = ticks;
-	while (ticks == start)
-		barrier ();
+deadline_less (const struct list_elem *a_, const struct list_elem *b_,
+		void *aux UNUSED) {
+	const struct deadline_sleeper *a = list_entry (a_, struct deadline_sleeper, elem);
+	const struct deadline_sleeper *b = list_entry (b_, struct deadline_sleeper, elem);
+
+	return a->deadline < b->deadline;
+}
+
+/* Blocks for NS nanoseconds, until the local APIC timer wakes us
+   up. */
+static void
+deadline_sleep (int64_t ns) {
+	struct deadline_sleeper s;
+	enum intr_level old_level;
+
+	s.deadline = timer_ns () + ns;
+	sema_init (&s.sema, 0);
 
-	/* Run LOOPS loops. */
-	start = ticks;
-	busy_wait (loops);
+	old_level = intr_disable ();
+	list_insert_ordered (&deadline_sleepers, &s.elem, deadline_less, NULL);
+	if (list_front (&deadline_sleepers) == &s.elem)
+		arm_lapic (ns);
+	intr_set_level (old_level);
+
+	sema_down (&s.sema);
+}
 
-	/* If the tick count changed, we iterated too long. */
-	barrier ();
-	return start != ticks;
+/* Arms the local APIC timer to interrupt in NS nanoseconds, or
+   as close to that as its 32-bit counter reaches. */
+static void
+arm_lapic (int64_t ns) {
+	int64_t count = (ns / NSEC_PER_SEC) * lapic_hz
+		+ (ns % NSEC_PER_SEC) * lapic_hz / NSEC_PER_SEC;
+
+	if (count < 1)
+		count = 1;
+	else if (count > UINT32_MAX)
+		count = UINT32_MAX;
+	lapic_timer_start (count);
 }
 
-/* Iterates through a simple loop LOOPS times, for implementing
-   brief delays.
+/* Busy-waits for NS nanoseconds. */
+static void
+spin (int64_t ns) {
+	uint64_t start = rdtsc ();
+	uint64_t cycles = (ns / NSEC_PER_SEC) * tsc_hz
+		+ (ns % NSEC_PER_SEC) * tsc_hz / NSEC_PER_SEC;
 
-   Marked NO_INLINE because code alignment can significantly
-   affect timings, so that if this function was inlined
-   differently in different places the results would be difficult
-   to predict. */
-static void NO_INLINE
-busy_wait (int64_t loops) {
-	while (loops-- > 0)
+	ASSERT (tsc_hz != 0);
+	while (rdtsc () - start < cycles)
 		barrier ();
 }
 
+/* Converts CYCLES of a clock running at HZ to nanoseconds,
+   without overflowing for any realistic uptime. */
+static int64_t
+cycles_to_ns (uint64_t cycles, uint64_t hz) {
+	return (cycles / hz) * NSEC_PER_SEC + (cycles % hz) * NSEC_PER_SEC / hz;
+}
+
 /* Sleep for approximately NUM/DENOM seconds. */
 static void
 real_time_sleep (int64_t num, int32_t denom) {
-	/* Convert NUM/DENOM seconds into timer ticks, rounding down.
-
-	   (NUM / DENOM) s
-	   ---------------------- = NUM * TIMER_FREQ / DENOM ticks.
-	   1 s / TIMER_FREQ ticks
-	   */
-	int64_t ticks = num * TIMER_FREQ / denom;
+	int64_t ns = num * (NSEC_PER_SEC / denom);
 
 	ASSERT (intr_get_level () == INTR_ON);
-	if (ticks > 0) {
+	ASSERT (NSEC_PER_SEC % denom == 0);
+	if (ns <= 0)
+		return;
+
+	if (lapic_hz != 0 && ns >= SPIN_NS) {
+		/* Block, and have the local APIC timer wake us up at
+		   the deadline. */
+		deadline_sleep (ns);
+	} else if (ns >= NSEC_PER_SEC / TIMER_FREQ) {
 		/* We're waiting for at least one full timer tick.  Use
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
-		timer_sleep (ticks);
+		timer_sleep (ns / (NSEC_PER_SEC / TIMER_FREQ));
 	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
-		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		/* Otherwise, spin on the TSC for more accurate sub-tick
+		   timing. */
+		spin (ns);
 	}
 }
@@ -25,6 +25,7 @@ static size_t cx, cy;
    The attribute at (x,y) is fb[y][x][1]. */
 static uint8_t (*fb)[COL_CNT][2];
 
+static void putc_no_cursor (int c);
 static void clear_row (size_t y);
 static void cls (void);
 static void newline (void);
@@ -52,7 +53,34 @@ vga_putc (int c) {
 	enum intr_level old_level = intr_disable ();
 
 	init ();
+	putc_no_cursor (c);
 
+	/* Update cursor position. */
+	move_cursor ();
+
+	intr_set_level (old_level);
+}
+
+/* Writes the N characters in BUFFER to the VGA text display.
+   Equivalent to calling vga_putc() on each character, but
+   interrupts are toggled and the hardware cursor is moved only
+   once for the whole buffer. */
+void
+vga_putbuf (const char *buffer, size_t n) {
+	enum intr_level old_level = intr_disable ();
+
+	init ();
+	while (n-- > 0)
+		putc_no_cursor (*buffer++);
+	move_cursor ();
+
+	intr_set_level (old_level);
+}
+
+/* Writes C to the framebuffer and advances (cx,cy), without
+   touching the hardware cursor. */
+static void
+putc_no_cursor (int c) {
 	switch (c) {
 		case '\n':
 			newline ();
@@ -84,13 +112,8 @@ vga_putc (int c) {
 				newline ();
 			break;
 	}
-
-	/* Update cursor position. */
-	move_cursor ();
-
-	intr_set_level (old_level);
 }
-
+
 /* Clears the screen and moves the cursor to the upper left. */
 static void
 cls (void) {
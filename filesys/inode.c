@@ -10,13 +10,25 @@
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* Maximum number of unwritten extents tracked per inode. */
+#define UNWRITTEN_MAX 62
+
+/* A run of data sectors that has been allocated but never
+ * written.  Reads from it return zeros without touching the
+ * disk, so inode_create() does not have to zero-fill. */
+struct unwritten_extent {
+	uint32_t start;                     /* First sector index in file. */
+	uint32_t count;                     /* Number of sectors. */
+};
+
 /* On-disk inode.
  * Must be exactly DISK_SECTOR_SIZE bytes long. */
 struct inode_disk {
 	disk_sector_t start;                /* First data sector. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	uint32_t unwritten_cnt;             /* Entries used in unwritten[]. */
+	struct unwritten_extent unwritten[UNWRITTEN_MAX];
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -33,6 +45,8 @@ struct inode {
 	int open_cnt;                       /* Number of openers. */
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
+	bool dirty;                         /* DATA differs from disk copy. */
+	unsigned write_gen;                 /* Bumped by every write. */
 	struct inode_disk data;             /* Inode content. */
 };
 
@@ -49,6 +63,82 @@ byte_to_sector (const struct inode *inode, off_t pos) {
 		return -1;
 }
 
+/* Returns the index in INODE's unwritten[] of the extent that
+ * holds sector index IDX within the file, or -1 if that sector
+ * has been written. */
+static int
+find_unwritten (const struct inode *inode, uint32_t idx) {
+	const struct inode_disk *data = &inode->data;
+	uint32_t i;
+
+	for (i = 0; i < data->unwritten_cnt; i++) {
+		const struct unwritten_extent *e = &data->unwritten[i];
+		if (idx >= e->start && idx - e->start < e->count)
+			return i;
+	}
+	return -1;
+}
+
+/* Returns true if the sector holding byte offset POS within
+ * INODE has never been written and therefore reads as zeros. */
+static bool
+is_unwritten (const struct inode *inode, off_t pos) {
+	return find_unwritten (inode, pos / DISK_SECTOR_SIZE) >= 0;
+}
+
+/* A sector full of zeros. */
+static char zeros[DISK_SECTOR_SIZE];
+
+/* Writes zeros to sector indexes START...START+CNT-1 of INODE. */
+static void
+zero_sectors (struct inode *inode, uint32_t start, uint32_t cnt) {
+	uint32_t i;
+
+	for (i = 0; i < cnt; i++)
+		disk_write (filesys_disk, inode->data.start + start + i, zeros);
+}
+
+/* Records that sector index IDX of INODE now holds real data,
+ * carving it out of the unwritten extent that contains it.  If
+ * that requires a split and the extent table is full, the
+ * shorter side of the split is zero-filled on disk instead.
+ * Only the in-memory copy changes; inode_write_at() writes it
+ * back. */
+static void
+mark_written (struct inode *inode, uint32_t idx) {
+	struct inode_disk *data = &inode->data;
+	int i = find_unwritten (inode, idx);
+	struct unwritten_extent *e;
+	uint32_t end;
+
+	if (i < 0)
+		return;
+
+	e = &data->unwritten[i];
+	end = e->start + e->count;
+	if (e->count == 1)
+		*e = data->unwritten[--data->unwritten_cnt];
+	else if (idx == e->start) {
+		e->start++;
+		e->count--;
+	} else if (idx == end - 1)
+		e->count--;
+	else if (data->unwritten_cnt < UNWRITTEN_MAX) {
+		struct unwritten_extent *tail = &data->unwritten[data->unwritten_cnt++];
+		tail->start = idx + 1;
+		tail->count = end - (idx + 1);
+		e->count = idx - e->start;
+	} else if (idx - e->start <= end - (idx + 1)) {
+		zero_sectors (inode, e->start, idx - e->start);
+		e->count = end - (idx + 1);
+		e->start = idx + 1;
+	} else {
+		zero_sectors (inode, idx + 1, end - (idx + 1));
+		e->count = idx - e->start;
+	}
+	inode->dirty = true;
+}
+
 /* List of open inodes, so that opening a single inode twice
  * returns the same `struct inode'. */
 static struct list open_inodes;
@@ -61,7 +151,9 @@ inode_init (void) {
 
 /* Initializes an inode with LENGTH bytes of data and
  * writes the new inode to sector SECTOR on the file system
- * disk.
+ * disk.  The data sectors are allocated but not zeroed; they are
+ * recorded as a single unwritten extent and read back as zeros
+ * until something is written to them.
  * Returns true if successful.
  * Returns false if memory or disk allocation fails. */
 bool
@@ -81,14 +173,12 @@ inode_create (disk_sector_t sector, off_t length) {
 		disk_inode->length = length;
 		disk_inode->magic = INODE_MAGIC;
 		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
 			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
+				disk_inode->unwritten_cnt = 1;
+				disk_inode->unwritten[0].start = 0;
+				disk_inode->unwritten[0].count = sectors;
 			}
+			disk_write (filesys_disk, sector, disk_inode);
 			success = true; 
 		} 
 		free (disk_inode);
@@ -125,6 +215,7 @@ inode_open (disk_sector_t sector) {
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	inode->dirty = false;
 	disk_read (filesys_disk, inode->sector, &inode->data);
 	return inode;
 }
@@ -200,7 +291,10 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
+		if (is_unwritten (inode, offset)) {
+			/* Never written: reads as zeros, no disk access. */
+			memset (buffer + bytes_read, 0, chunk_size);
+		} else if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
 			/* Read full sector directly into caller's buffer. */
 			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
 		} else {
@@ -239,6 +333,7 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
 	if (inode->deny_write_cnt)
 		return 0;
+	inode->write_gen++;
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -268,14 +363,17 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 
 			/* If the sector contains data before or after the chunk
 			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
+			   first.  Otherwise, or if the sector was never written,
+			   we start with a sector of all zeros. */
+			if ((sector_ofs > 0 || chunk_size < sector_left)
+					&& !is_unwritten (inode, offset))
 				disk_read (filesys_disk, sector_idx, bounce);
 			else
 				memset (bounce, 0, DISK_SECTOR_SIZE);
 			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
 			disk_write (filesys_disk, sector_idx, bounce); 
 		}
+		mark_written (inode, offset / DISK_SECTOR_SIZE);
 
 		/* Advance. */
 		size -= chunk_size;
@@ -284,6 +382,15 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 	}
 	free (bounce);
 
+	/* Write the extent table back before returning, once per call,
+	   so that the data just written is never hidden behind a stale
+	   unwritten extent on disk if the system stops before the
+	   inode is closed. */
+	if (inode->dirty) {
+		disk_write (filesys_disk, inode->sector, &inode->data);
+		inode->dirty = false;
+	}
+
 	return bytes_written;
 }
 
@@ -311,3 +418,11 @@ off_t
 inode_length (const struct inode *inode) {
 	return inode->data.length;
 }
+
+/* Returns a counter that changes whenever INODE is written, so that
+   callers caching data derived from INODE can tell whether it is
+   still current. */
+unsigned
+inode_write_gen (const struct inode *inode) {
+	return inode->write_gen;
+}
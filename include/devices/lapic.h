@@ -0,0 +1,15 @@
+#ifndef DEVICES_LAPIC_H
+#define DEVICES_LAPIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Interrupt vector for the local APIC timer. */
+#define LAPIC_TIMER_VEC 0x40
+
+bool lapic_init (void);
+void lapic_eoi (void);
+void lapic_timer_start (uint32_t count);
+uint32_t lapic_timer_remaining (void);
+
+#endif /* devices/lapic.h */
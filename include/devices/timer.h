@@ -9,9 +9,12 @@
 
 void timer_init (void);
 void timer_calibrate (void);
+void timer_use_lapic (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
+uint64_t timer_tsc_hz (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
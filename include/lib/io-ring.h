@@ -0,0 +1,104 @@
+#ifndef __LIB_IO_RING_H
+#define __LIB_IO_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Submission/completion ring for batched file I/O.
+
+   A program queues requests in the submission queue (SQ) and then
+   makes one io_ring_enter() system call.  The kernel runs the
+   queued requests in order and posts one completion per request
+   to the completion queue (CQ), until the SQ is empty or the CQ
+   is full.
+
+   Both queues are indexed by free-running counters: entry I of a
+   queue is at index I % IO_RING_SIZE.  The program owns sq_tail
+   and cq_head; the kernel owns sq_head and cq_tail. */
+
+#define IO_RING_SIZE 64         /* Entries in each queue. */
+
+/* Request types. */
+enum io_op {
+	IO_OP_NOP,                  /* Do nothing. */
+	IO_OP_READ,                 /* read (fd, addr, len). */
+	IO_OP_WRITE,                /* write (fd, addr, len). */
+	IO_OP_SEEK,                 /* seek (fd, pos). */
+	IO_OP_OPEN,                 /* open (addr); result is the fd. */
+	IO_OP_CLOSE,                /* close (fd). */
+	IO_OP_FSYNC,                /* Flush fd's data to disk. */
+};
+
+/* A request. */
+struct io_sqe {
+	uint32_t op;                /* An enum io_op. */
+	int32_t fd;                 /* File descriptor. */
+	uint64_t addr;              /* Buffer or file name. */
+	uint32_t len;               /* Buffer size. */
+	uint32_t pos;               /* File position for IO_OP_SEEK. */
+	uint64_t user_data;         /* Copied to the completion. */
+};
+
+/* A completion. */
+struct io_cqe {
+	uint64_t user_data;         /* From the request. */
+	int32_t res;                /* Result as from the system call, or
+	                               -1 on error. */
+	uint32_t flags;             /* Unused, 0. */
+};
+
+/* The ring, in the program's memory. */
+struct io_ring {
+	uint32_t sq_head;           /* Next request for the kernel. */
+	uint32_t sq_tail;           /* Next free request slot. */
+	uint32_t cq_head;           /* Next completion for the program. */
+	uint32_t cq_tail;           /* Next free completion slot. */
+	struct io_sqe sqes[IO_RING_SIZE];
+	struct io_cqe cqes[IO_RING_SIZE];
+};
+
+/* Helpers for programs. */
+
+static inline void
+io_ring_init (struct io_ring *ring) {
+	ring->sq_head = ring->sq_tail = 0;
+	ring->cq_head = ring->cq_tail = 0;
+}
+
+/* Queues a request and returns true, or returns false if the SQ
+   is full.  For IO_OP_SEEK, LEN is the new position. */
+static inline bool
+io_ring_queue (struct io_ring *ring, enum io_op op, int fd, const void *addr,
+		uint32_t len, uint64_t user_data) {
+	struct io_sqe *sqe;
+
+	if (ring->sq_tail - ring->sq_head == IO_RING_SIZE)
+		return false;
+	sqe = &ring->sqes[ring->sq_tail % IO_RING_SIZE];
+	sqe->op = op;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t) addr;
+	sqe->len = len;
+	sqe->pos = op == IO_OP_SEEK ? len : 0;
+	sqe->user_data = user_data;
+	ring->sq_tail++;
+	return true;
+}
+
+/* Returns the oldest unconsumed completion, or a null pointer if
+   there is none. */
+static inline struct io_cqe *
+io_ring_peek (struct io_ring *ring) {
+	if (ring->cq_head == ring->cq_tail)
+		return NULL;
+	return &ring->cqes[ring->cq_head % IO_RING_SIZE];
+}
+
+/* Consumes the completion returned by io_ring_peek(). */
+static inline void
+io_ring_advance (struct io_ring *ring) {
+	ring->cq_head++;
+}
+
+#endif /* lib/io-ring.h */
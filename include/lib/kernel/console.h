@@ -1,7 +1,10 @@
 #ifndef __LIB_KERNEL_CONSOLE_H
 #define __LIB_KERNEL_CONSOLE_H
 
+#include <stdbool.h>
+
 void console_init (void);
+void console_set_vga (bool enabled);
 void console_panic (void);
 void console_print_stats (void);
 
@@ -6,28 +6,45 @@
  * This data structure is thoroughly documented in the Tour of
  * Pintos for Project 3.
  *
- * This is a standard hash table with chaining.  To locate an
- * element in the table, we compute a hash function over the
- * element's data and use that as an index into an array of
- * doubly linked lists, then linearly search the list.
+ * This is an open-addressing hash table with Robin Hood linear
+ * probing.  The table is an array of slots, each holding a
+ * pointer to an element and the element's hash value.  To locate
+ * an element, we compute a hash function over the element's data,
+ * use it to pick a home slot, and scan forward from there.  Robin
+ * Hood insertion keeps every run of slots ordered by distance from
+ * home, so a scan can stop as soon as it passes the point where
+ * the element would have been.  Comparing stored hash values
+ * first means the comparison function is rarely called for
+ * elements that don't match, and scanning adjacent slots is
+ * friendly to the cache, unlike walking a chain.
  *
- * The chain lists do not use dynamic allocation.  Instead, each
- * structure that can potentially be in a hash must embed a
+ * The table does not allocate anything per element.  Instead,
+ * each structure that can potentially be in a hash must embed a
  * struct hash_elem member.  All of the hash functions operate on
  * these `struct hash_elem's.  The hash_entry macro allows
  * conversion from a struct hash_elem back to a structure object
  * that contains it.  This is the same technique used in the
  * linked list implementation.  Refer to lib/kernel/list.h for a
- * detailed explanation. */
+ * detailed explanation.
+ *
+ * When the table fills up or empties out, it is resized
+ * incrementally: a new slot array is allocated and each later
+ * insertion or deletion moves a few elements from the old array to
+ * the new one, so that no single operation pays for moving the
+ * whole table.  If a larger array cannot be allocated, elements
+ * that no longer fit go on a list threaded through their
+ * hash_elems until a later resize succeeds, so that inserting
+ * never fails. */
 
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
-#include "list.h"
 
-/* Hash element. */
+/* Hash element.  The table keeps its bookkeeping in its slot
+ * array; the element only holds a link for the rare case that the
+ * slot array is full and cannot grow. */
 struct hash_elem {
-	struct list_elem list_elem;
+	struct hash_elem *next;     /* Next in the table's overflow list. */
 };
 
 /* Converts pointer to hash element HASH_ELEM into a pointer to
@@ -40,8 +57,8 @@ struct hash_elem {
 	(hash_elem 값이 들어있는 변수명, struct page, hash_elem)
 */
 #define hash_entry(HASH_ELEM, STRUCT, MEMBER)                   \
-	((STRUCT *) ((uint8_t *) &(HASH_ELEM)->list_elem        \
-		- offsetof (STRUCT, MEMBER.list_elem)))
+	((STRUCT *) ((uint8_t *) (HASH_ELEM)                    \
+		- offsetof (STRUCT, MEMBER)))
 
 /* Computes and returns the hash value for hash element E, given
  * auxiliary data AUX. */
@@ -58,16 +75,34 @@ typedef bool hash_less_func (const struct hash_elem *a,
  * data AUX. */
 typedef void hash_action_func (struct hash_elem *e, void *aux);
 
+/* A slot in a hash table: an element and its scrambled hash
+ * value, or a null ELEM if the slot is empty. */
+struct hash_slot {
+	uint64_t hash;              /* Scrambled hash value of ELEM. */
+	struct hash_elem *elem;     /* Element, or null if empty. */
+};
+
+/* An array of slots. */
+struct hash_table {
+	struct hash_slot *slots;    /* Array of `slot_cnt' slots, or null. */
+	size_t slot_cnt;            /* Number of slots, a power of 2. */
+	size_t elem_cnt;            /* Number of occupied slots. */
+	int shift;                  /* 64 - log2 (slot_cnt). */
+};
+
 /* Hash table. */
 /*
 	Hash 구조체
 	: Key와 Value로 구성되어 있음
-	: 실제 값이 buckets에 들어감
+	: 실제 값이 cur의 slot 배열에 들어감, 크기를 바꾸는 동안에는 old에도 들어 있음
 */
 struct hash {
 	size_t elem_cnt;            /* Number of elements in table. */
-	size_t bucket_cnt;          /* Number of buckets, a power of 2. */
-	struct list *buckets;       /* Array of `bucket_cnt' lists. */
+	struct hash_table cur;      /* Slots new elements go into. */
+	struct hash_table old;      /* While resizing, slots being moved into
+	                               `cur'; otherwise empty. */
+	size_t move_idx;            /* Next slot of `old' to move. */
+	struct hash_elem *overflow; /* Elements that did not fit in `cur'. */
 	hash_hash_func *hash;       /* Hash function. */
 	hash_less_func *less;       /* Comparison function. */
 	void *aux;                  /* Auxiliary data for `hash' and `less'. */
@@ -76,8 +111,10 @@ struct hash {
 /* A hash table iterator. */
 struct hash_iterator {
 	struct hash *hash;          /* The hash table. */
-	struct list *bucket;        /* Current bucket. */
-	struct hash_elem *elem;     /* Current hash element in current bucket. */
+	struct hash_table *table;   /* Current slot array, or null once
+	                               in the overflow list. */
+	size_t idx;                 /* Next slot in current array. */
+	struct hash_elem *elem;     /* Current hash element. */
 };
 
 /* Basic life cycle. */
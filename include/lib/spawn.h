@@ -0,0 +1,14 @@
+#ifndef __LIB_SPAWN_H
+#define __LIB_SPAWN_H
+
+/* A spawn() fd action: the child gets the caller's PARENT_FD as
+   CHILD_FD. */
+struct spawn_fd {
+	int child_fd;
+	int parent_fd;
+};
+
+/* Maximum number of fd actions passed to spawn(). */
+#define SPAWN_FD_MAX 16
+
+#endif /* lib/spawn.h */
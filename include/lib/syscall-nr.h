@@ -36,6 +36,19 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extensions. */
+	SYS_SPAWN,                  /* Start a new process from a file. */
+	SYS_TRACE_DUMP,             /* Write the kernel event trace to a file. */
+	SYS_CLOCK_GETTIME,          /* Read a clock with nanosecond resolution. */
+	SYS_SYSCALL_STATS,          /* Read system call statistics. */
+	SYS_IO_RING_ENTER,          /* Run queued requests in an I/O ring. */
+	SYS_PREAD,                  /* Read from a file at a given offset. */
+	SYS_PWRITE,                 /* Write to a file at a given offset. */
+	SYS_READV,                  /* Read into several buffers. */
+	SYS_WRITEV,                 /* Write from several buffers. */
+
+	SYS_CNT                     /* Number of system calls. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,22 @@
+#ifndef __LIB_SYSCALL_STAT_H
+#define __LIB_SYSCALL_STAT_H
+
+#include <stdint.h>
+
+/* Statistics for one system call, as returned by the
+   syscall_stats() system call, indexed by SYS_* number.  Times
+   are TSC cycles from the kernel's entry into syscall_handler()
+   to its return.  Calls that never return, such as exit(), or
+   that kill the process are not counted. */
+struct syscall_stat {
+	uint64_t count;             /* Calls. */
+	uint64_t errors;            /* Calls that reported failure. */
+	uint64_t cycles;            /* Total cycles. */
+	uint64_t max_cycles;        /* Longest call. */
+};
+
+/* Scopes for syscall_stats(). */
+#define SYSCALL_STATS_SELF 0    /* Calls by the calling process. */
+#define SYSCALL_STATS_ALL 1     /* Calls by every process since boot. */
+
+#endif /* lib/syscall-stat.h */
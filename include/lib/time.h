@@ -0,0 +1,14 @@
+#ifndef __LIB_TIME_H
+#define __LIB_TIME_H
+
+/* Clocks for clock_gettime().  Pintos has no real-time clock, so
+   the only one counts from boot. */
+#define CLOCK_MONOTONIC 1
+
+/* A time as returned by clock_gettime(). */
+struct timespec {
+	long long tv_sec;           /* Seconds. */
+	long tv_nsec;               /* Nanoseconds, 0 to 999,999,999. */
+};
+
+#endif /* lib/time.h */
@@ -0,0 +1,56 @@
+#ifndef __LIB_TRACE_EVENT_H
+#define __LIB_TRACE_EVENT_H
+
+#include <stdint.h>
+
+/* Format of the kernel trace written by the trace_dump() system
+   call and read by utils/pintos-trace.  A dump is a struct
+   trace_header followed by EVENT_CNT struct trace_events, oldest
+   first. */
+
+#define TRACE_MAGIC "PINTRACE"
+#define TRACE_VERSION 1
+
+/* The kernel keeps the most recent TRACE_EVENT_CNT events. */
+#define TRACE_EVENT_CNT 4096
+
+/* Kinds of events.  TID is the thread the event happened in;
+   ARG[] as noted. */
+enum trace_type {
+	TRACE_THREAD_NAME,          /* Thread created; ARG holds its name. */
+	TRACE_SCHEDULE,             /* Switched away; next tid, old status. */
+	TRACE_WAKEUP,               /* Made a thread ready; woken tid. */
+	TRACE_BLOCK,                /* Blocked; sema or rwlock, lock. */
+	TRACE_PAGE_FAULT,           /* Page fault; address, error code. */
+	TRACE_SYSCALL_ENTER,        /* System call; number, first argument. */
+	TRACE_SYSCALL_EXIT,         /* System call returns; number, result. */
+	TRACE_DISK_READ,            /* Disk read issued; sector, disk. */
+	TRACE_DISK_WRITE,           /* Disk write issued; sector, disk. */
+	TRACE_DISK_DONE,            /* Disk request completed; sector, disk. */
+	TRACE_TYPE_CNT
+};
+
+/* One event. */
+struct trace_event {
+	uint64_t tsc;               /* Time-stamp counter. */
+	uint32_t type;              /* A TRACE_* value. */
+	int32_t tid;                /* Thread. */
+	uint64_t arg[2];            /* Type-specific arguments. */
+};
+
+/* Start of a dump.  The times let a reader convert TSC cycles to
+   seconds: TIMER_FREQ ticks per second. */
+struct trace_header {
+	char magic[8];              /* TRACE_MAGIC, not null-terminated. */
+	uint32_t version;           /* TRACE_VERSION. */
+	uint32_t event_size;        /* sizeof (struct trace_event). */
+	uint64_t event_cnt;         /* Number of events that follow. */
+	uint64_t lost_cnt;          /* Events overwritten before the dump. */
+	uint64_t tsc_start;         /* TSC when tracing started. */
+	uint64_t tsc_end;           /* TSC when the dump was taken. */
+	int64_t ticks_start;        /* Timer ticks when tracing started. */
+	int64_t ticks_end;          /* Timer ticks when the dump was taken. */
+	uint64_t timer_freq;        /* Timer ticks per second. */
+};
+
+#endif /* lib/trace-event.h */
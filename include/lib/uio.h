@@ -0,0 +1,15 @@
+#ifndef __LIB_UIO_H
+#define __LIB_UIO_H
+
+#include <stddef.h>
+
+/* One buffer of a readv() or writev() call. */
+struct iovec {
+	void *iov_base;             /* Start of the buffer. */
+	size_t iov_len;             /* Bytes in the buffer. */
+};
+
+/* Maximum number of buffers in one readv() or writev() call. */
+#define IOV_MAX 1024
+
+#endif /* lib/uio.h */
@@ -4,6 +4,11 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <io-ring.h>
+#include <spawn.h>
+#include <syscall-stat.h>
+#include <time.h>
+#include <uio.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -25,6 +30,8 @@ void halt (void) NO_RETURN;
 void exit (int status) NO_RETURN;
 pid_t fork (const char *thread_name);
 int exec (const char *file);
+pid_t spawn (const char *cmd_line, const struct spawn_fd *fd_actions,
+		size_t fd_cnt);
 int wait (pid_t);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
@@ -50,6 +57,16 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Extensions. */
+int trace_dump (int fd);
+int clock_gettime (int clock_id, struct timespec *ts);
+int syscall_stats (int scope, struct syscall_stat *stats, int cnt);
+int io_ring_enter (struct io_ring *ring);
+int pread (int fd, void *buffer, unsigned length, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned length, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -8,5 +8,6 @@
 #define FLAG_IOPL  (3<<12)
 #define FLAG_AC    (1<<18)
 #define FLAG_NT    (1<<14)
+#define FLAG_RF    (1<<16)
 
 #endif /* threads/flags.h */
@@ -1,6 +1,7 @@
 #ifndef THREADS_INTERRUPT_H
 #define THREADS_INTERRUPT_H
 
+#include <list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -74,5 +75,48 @@ void intr_yield_on_return (void);
 
 void intr_dump_frame (const struct intr_frame *);
 const char *intr_name (uint8_t vec);
+void intr_print_stats (void);
+
+/* Interrupts-off profiling.  If intr_prof is true, the kernel
+   times every stretch with interrupts off and intr_print_stats()
+   reports the longest ones.  Controlled by kernel command-line
+   option "-intr-prof".  intr_prof_bound is the longest such
+   stretch, in microseconds, that tests accept; it defaults to one
+   timer tick and is set by "-intr-bound=US". */
+extern bool intr_prof;
+extern int intr_prof_bound;
+void intr_prof_reset (void);
+int64_t intr_prof_longest (void);
+
+/* Deferred interrupt work ("softirq").
+
+   An external interrupt handler runs with interrupts off, so
+   anything it does delays every other interrupt.  A handler that
+   has more to do than acknowledge its device should instead
+   raise a softirq with softirq_raise().  Pending softirqs run
+   one after another just before the outermost interrupt
+   returns, with interrupts turned back on.
+
+   A softirq function runs in interrupt context: it may not
+   sleep, but may call intr_yield_on_return().  Raising a softirq
+   that is already pending has no further effect, so the
+   function must handle everything that accumulated since it
+   last ran. */
+typedef void softirq_func (void *aux);
+
+struct softirq {
+	softirq_func *func;         /* Function to run. */
+	void *aux;                  /* Auxiliary data for FUNC. */
+	bool pending;               /* In the pending list? */
+	struct list_elem elem;      /* Pending list element. */
+};
+
+void softirq_init (struct softirq *, softirq_func *, void *aux);
+void softirq_raise (struct softirq *);
+
+/* If true, softirq_raise() runs the work at once, with
+   interrupts off, inside the handler that raised it.
+   Controlled by kernel command-line option "-no-softirq". */
+extern bool intr_no_softirq;
 
 #endif /* threads/interrupt.h */
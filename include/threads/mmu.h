@@ -8,12 +8,19 @@
 typedef bool pte_for_each_func (uint64_t *pte, void *va, void *aux);
 
 uint64_t *pml4e_walk (uint64_t *pml4, const uint64_t va, int create);
+bool pml4_set_large_page (uint64_t *pml4, uint64_t va, uint64_t pa,
+		uint64_t flags);
 uint64_t *pml4_create (void);
 bool pml4_for_each (uint64_t *, pte_for_each_func *, void *);
 void pml4_destroy (uint64_t *pml4);
 void pml4_activate (uint64_t *pml4);
+void pml4_enable_pcid (void);
 void *pml4_get_page (uint64_t *pml4, const void *upage);
 bool pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw);
+size_t pml4_set_pages (uint64_t *pml4, void *upage, void *kpage, size_t cnt,
+		bool rw);
+size_t pml4_share_pages (uint64_t *pml4, void *upage, void *kpage,
+		size_t cnt);
 void pml4_clear_page (uint64_t *pml4, void *upage);
 bool pml4_is_dirty (uint64_t *pml4, const void *upage);
 void pml4_set_dirty (uint64_t *pml4, const void *upage, bool dirty);
@@ -3,11 +3,48 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Wait queue.
+
+   Threads waiting on a semaphore or condition variable, highest
+   priority first and, among equal priorities, first come first
+   served.  It is a pairing heap: insertion and raising an
+   element's priority take constant time, and removing the first
+   element takes O(log n) amortized time.  All operations must be
+   done with interrupts off. */
+struct wait_elem {
+	struct wait_elem *child;    /* First child. */
+	struct wait_elem *next;     /* Next sibling. */
+	struct wait_elem *prev;     /* Previous sibling, or parent. */
+	struct wait_queue *queue;   /* Queue we're in, or null. */
+	int priority;               /* Key. */
+	uint64_t seq;               /* Insertion order, to break ties. */
+};
+
+struct wait_queue {
+	struct wait_elem *root;     /* First element, or null if empty. */
+};
+
+/* Converts pointer to wait element WAIT_ELEM into a pointer to
+   the structure that WAIT_ELEM is embedded inside. */
+#define wait_entry(WAIT_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) (WAIT_ELEM)            \
+		- offsetof (STRUCT, MEMBER)))
+
+struct thread;
+
+void wait_queue_init (struct wait_queue *);
+bool wait_queue_empty (const struct wait_queue *);
+void wait_queue_push (struct wait_queue *, struct wait_elem *, int priority);
+struct wait_elem *wait_queue_pop (struct wait_queue *);
+void wait_queue_update (struct thread *);
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct wait_queue waiters;  /* Waiting threads. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,17 +57,33 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct lock_stats *stats;   /* Contention statistics, or null. */
+};
+
+/* Contention statistics for a named lock.  Times are in TSC
+   cycles. */
+struct lock_stats {
+	const char *name;           /* Name, for lock_print_stats(). */
+	uint64_t acquire_cnt;       /* Number of acquisitions. */
+	uint64_t contended_cnt;     /* Acquisitions that had to wait. */
+	uint64_t wait_total;        /* Total time spent waiting. */
+	uint64_t wait_max;          /* Longest wait. */
+	uint64_t hold_total;        /* Total time held. */
+	uint64_t hold_max;          /* Longest hold. */
+	uint64_t acquired_at;       /* When the holder acquired it. */
 };
 
 void lock_init (struct lock *);
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_print_stats (void);
 
 /* Condition variable. */
 struct condition {
-	struct list waiters;        /* List of waiting threads. */
+	struct wait_queue waiters;  /* Waiting threads' semaphores. */
 };
 
 void cond_init (struct condition *);
@@ -38,6 +91,51 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock. */
+struct rwlock {
+	struct thread *writer;      /* Thread holding it for writing, or null. */
+	unsigned reader_cnt;        /* Number of threads holding it for reading. */
+	struct list readers;        /* Readers' struct rwlock_holds. */
+	struct wait_queue read_waiters;  /* Threads waiting to read. */
+	struct wait_queue write_waiters; /* Threads waiting to write. */
+};
+
+/* One of the rwlocks a thread holds, in either mode.  Each
+   thread has RWLOCK_HOLD_MAX of these in its struct thread. */
+struct rwlock_hold {
+	struct rwlock *rwlock;      /* Lock held, or null if unused. */
+	struct thread *thread;      /* Thread holding it. */
+	struct list_elem elem;      /* In rwlock's `readers' if reading. */
+};
+#define RWLOCK_HOLD_MAX 8
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_write_held_by_current_thread (const struct rwlock *);
+void rwlock_donate (struct rwlock *, int priority, int depth);
+int rwlock_waiter_priority (const struct rwlock *);
+
+/* Sequence lock.
+
+   Lets readers of a small piece of data read it without locking,
+   by retrying if a writer changed it meanwhile:
+
+	   do {
+		   seq = seqlock_read_begin (&s);
+		   ...read data...
+	   } while (seqlock_read_retry (&s, seq));
+
+   Writers must not run concurrently with each other, and must not
+   be preempted while writing, so write with interrupts off or from
+   an interrupt handler.  Otherwise a reader could spin forever
+   waiting for a preempted writer to finish. */
+struct seqlock {
+	unsigned seq;               /* Odd while a write is in progress. */
+};
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -45,9 +143,44 @@ void cond_broadcast (struct condition *, struct lock *);
  * reference guide for more information.*/
 #define barrier() asm volatile ("" : : : "memory")
 
-bool
-cmp_sem_priority(const struct list_elem *a,
-				 const struct list_elem *b,
-				 void *aux);
+/* Initializes seqlock S. */
+static inline void
+seqlock_init (struct seqlock *s) {
+	s->seq = 0;
+}
+
+/* Starts a read of data protected by S.  Returns a value to pass
+   to seqlock_read_retry(). */
+static inline unsigned
+seqlock_read_begin (const struct seqlock *s) {
+	unsigned seq;
+
+	while ((seq = *(const volatile unsigned *) &s->seq) & 1)
+		barrier ();
+	barrier ();
+	return seq;
+}
+
+/* Returns true if the read of data protected by S that started
+   when seqlock_read_begin() returned SEQ must be retried. */
+static inline bool
+seqlock_read_retry (const struct seqlock *s, unsigned seq) {
+	barrier ();
+	return *(const volatile unsigned *) &s->seq != seq;
+}
+
+/* Starts a write to data protected by S. */
+static inline void
+seqlock_write_begin (struct seqlock *s) {
+	*(volatile unsigned *) &s->seq = s->seq + 1;
+	barrier ();
+}
+
+/* Finishes a write to data protected by S. */
+static inline void
+seqlock_write_end (struct seqlock *s) {
+	barrier ();
+	*(volatile unsigned *) &s->seq = s->seq + 1;
+}
 
 #endif /* threads/synch.h */
@@ -2,6 +2,7 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
@@ -32,6 +33,22 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Exit record shared between a thread and its parent.
+
+   A thread's own page is freed as soon as it exits, so anything the
+   parent still needs afterward (the exit code, for wait()) lives
+   here instead.  The record is reference counted: one reference for
+   the child and one for the parent, and whichever lets go last
+   frees it. */
+struct child_status {
+	tid_t tid;                          /* Child's thread identifier. */
+	int exit_status;                    /* Exit code, valid once exited. */
+	int ref_cnt;                        /* 2 while both sides hold it. */
+	struct semaphore fork_sema;         /* Upped when fork() finishes. */
+	struct semaphore exit_sema;         /* Upped when the child exits. */
+	struct hash_elem elem;              /* Parent's `children' table. */
+};
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -84,11 +101,13 @@ typedef int tid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * the run queue (thread.c), or it can be an element in the sleep
+ * list (thread.c).  It can be used these two ways only because
+ * they are mutually exclusive: only a thread in the ready state is
+ * on the run queue, whereas only a blocked thread is asleep.
+ * Semaphore wait queues (synch.c) use `wait_elem' instead, which
+ * lets synch.c find a blocked thread's place in its queue when
+ * priority donation changes its priority. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
@@ -98,6 +117,8 @@ struct thread {
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
+	struct wait_elem wait_elem;         /* Semaphore wait queue element. */
+	struct wait_elem *cond_elem;        /* Condition variable wait, or null. */
 
 	// 각 스레드 당 깨어나야 Wake Time을 가짐
 	int64_t wake_time;
@@ -108,16 +129,17 @@ struct thread {
 	struct list donations;
 	struct list_elem donation_elem;
 
+	// Reader-writer lock 관련 파라미터들
+	struct rwlock *wait_on_rwlock;
+	struct rwlock_hold rwlock_holds[RWLOCK_HOLD_MAX];
+
 	// System Call 관련 파라미터들
 	int exit_status;
 	struct intr_frame parent_if;
 
-	struct list child_list;
-	struct list_elem child_elem;
-
-	struct semaphore wait_sema;
-	struct semaphore fork_sema;
-	struct semaphore free_sema;
+	struct hash children;               /* Children's child_status by tid. */
+	bool children_ready;                /* True once `children' is set up. */
+	struct child_status *child_status;  /* Own record, shared with parent. */
 
 	int fd_index;
 	struct file **fd_table;
@@ -127,9 +149,13 @@ struct thread {
 
 	struct file *running;
 
+	// 시스템 콜 번호별 통계 (SYS_CNT개), 첫 시스템 콜 때 할당
+	struct syscall_stat *syscall_stats;
+
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4;                     /* Page map level 4 */
+	struct image *image;                /* Cached executable image. */
 #endif
 #ifdef VM
 	/* Table for whole virtual memory owned by thread. */
@@ -154,6 +180,8 @@ void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+tid_t thread_create_joinable (const char *name, int priority,
+		thread_func *, void *);
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -175,6 +203,9 @@ int thread_get_load_avg (void);
 
 void do_iret (struct intr_frame *tf);
 
+struct child_status *thread_find_child (tid_t);
+void child_status_release (struct child_status *);
+
 int thread_sleep(int64_t ticks);
 int thread_awake(int64_t ticks);
 int64_t get_min_time();
@@ -188,6 +219,7 @@ bool cmp_donation_priority (const struct list_elem *a,
                             void *aux UNUSED);
 
 void donate_priority(void);
+void thread_donate(struct thread *t, int priority, int depth);
 void remove_with_lock(struct lock *lock);
 void refresh_priority(void);
 
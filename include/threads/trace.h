@@ -0,0 +1,20 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <trace-event.h>
+#include "threads/thread.h"
+#ifdef FILESYS
+#include "filesys/off_t.h"
+#endif
+
+void trace_init (void);
+void trace_event (enum trace_type, uint64_t, uint64_t);
+void trace_thread_event (tid_t, enum trace_type, uint64_t, uint64_t);
+void trace_thread_name (tid_t, const char *);
+
+#ifdef FILESYS
+struct file;
+off_t trace_write (struct file *);
+#endif
+
+#endif /* threads/trace.h */
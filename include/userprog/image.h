@@ -0,0 +1,56 @@
+#ifndef USERPROG_IMAGE_H
+#define USERPROG_IMAGE_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct file;
+struct inode;
+
+/* A run of pages to load, from one or more merged PT_LOAD
+   segments. */
+struct load_seg {
+	uint64_t file_page;         /* Page-aligned file offset. */
+	uint64_t mem_page;          /* Page-aligned user virtual address. */
+	uint32_t read_bytes;        /* Bytes to read from the file. */
+	uint32_t zero_bytes;        /* Bytes to zero after them. */
+	bool writable;
+};
+
+/* A segment of a cached image. */
+struct image_seg {
+	struct load_seg seg;
+	uint8_t *frames;            /* Read-only segment: its loaded pages,
+	                               physically contiguous, shared by every
+	                               process running the image.  Writable
+	                               segment: null, loaded per process. */
+};
+
+/* A cached executable: its parsed segment table and the frames of
+   its read-only segments.  Processes running the image hold
+   references to it; an image nobody runs stays cached until it is
+   evicted or its file is written. */
+struct image {
+	struct inode *inode;        /* Executable, the cache key. */
+	unsigned write_gen;         /* inode_write_gen() when loaded. */
+	uint64_t entry;             /* Entry point. */
+	struct image_seg *segs;     /* Segments, in address order. */
+	size_t seg_cnt;             /* Number of segments. */
+	size_t frame_cnt;           /* Number of shared frames. */
+	int ref_cnt;                /* Processes using the image. */
+	bool cached;                /* In the cache list? */
+	struct list_elem elem;      /* Cache list element. */
+};
+
+void image_init (void);
+struct image *image_lookup (struct file *);
+struct image *image_create (struct file *, uint64_t entry,
+		const struct load_seg *, size_t seg_cnt);
+struct image *image_dup (struct image *);
+void image_release (struct image *);
+bool image_evict (void);
+void image_print_stats (void);
+
+#endif /* userprog/image.h */
@@ -1,16 +1,18 @@
 #ifndef USERPROG_PROCESS_H
 #define USERPROG_PROCESS_H
 
+#include <spawn.h>
 #include "threads/thread.h"
 
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name, struct intr_frame *if_);
+tid_t process_spawn (char *cmd_line, const struct spawn_fd *, size_t fd_cnt);
 int process_exec (void *f_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
+void process_print_stats (void);
 
 void push_arguments(int argc, char **argv, struct intr_frame *if_);
-struct thread *find_child(int pid);
 
 #endif /* userprog/process.h */
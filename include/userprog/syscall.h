@@ -1,9 +1,15 @@
 #ifndef USERPROG_SYSCALL_H
 #define USERPROG_SYSCALL_H
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
 void syscall_init (void);
+void syscall_print_stats (void);
 
-void check_address (void *address);
+bool copy_in_string (char *dst, const char *usrc, size_t size);
+void check_buffer (const void *buffer, unsigned size, bool writable);
 
 struct lock file_lock;
 
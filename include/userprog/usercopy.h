@@ -0,0 +1,22 @@
+#ifndef USERPROG_USERCOPY_H
+#define USERPROG_USERCOPY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Accessors for user memory.
+
+   These touch user memory directly and let the MMU do the
+   checking.  An access that faults is redirected by page_fault()
+   through the exception table to a recovery point, so the caller
+   just sees a failure return instead of a kernel panic. */
+
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+int64_t strncpy_from_user (char *dst, const char *usrc, size_t size);
+bool probe_user (const void *ubuf, size_t size, bool write);
+
+uintptr_t search_exception_table (uintptr_t rip);
+
+#endif /* userprog/usercopy.h */
@@ -4,6 +4,7 @@
 #include "threads/palloc.h"
 
 #include "hash.h"
+#include "list.h"
 
 enum vm_type {
 	/* page not initialized */
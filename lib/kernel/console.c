@@ -59,10 +59,17 @@ static int console_lock_depth;
 /* Number of characters written to console. */
 static int64_t write_cnt;
 
+/* True (default) to mirror console output to the VGA display as
+   well as the serial port.  Cleared by the "-headless" kernel
+   command-line option, since nobody looks at the screen of a
+   machine run with -nographic and every character written there
+   costs a cursor update. */
+static bool mirror_vga = true;
+
 /* Enable console locking. */
 void
 console_init (void) {
-	lock_init (&console_lock);
+	lock_init_named (&console_lock, "console_lock");
 	use_console_lock = true;
 }
 
@@ -74,6 +81,13 @@ console_panic (void) {
 	use_console_lock = false;
 }
 
+/* Enables or disables mirroring console output to the VGA
+   display. */
+void
+console_set_vga (bool enabled) {
+	mirror_vga = enabled;
+}
+
 /* Prints console statistics. */
 void
 console_print_stats (void) {
@@ -138,12 +152,16 @@ puts (const char *s) {
 	return 0;
 }
 
-/* Writes the N characters in BUFFER to the console. */
+/* Writes the N characters in BUFFER to the console.
+   The whole buffer is handed to the serial and VGA layers at
+   once rather than one character at a time. */
 void
 putbuf (const char *buffer, size_t n) {
 	acquire_console ();
-	while (n-- > 0)
-		putchar_have_lock (*buffer++);
+	write_cnt += n;
+	serial_putbuf ((const uint8_t *) buffer, n);
+	if (mirror_vga)
+		vga_putbuf (buffer, n);
 	release_console ();
 }
 
@@ -173,5 +191,6 @@ putchar_have_lock (uint8_t c) {
 	ASSERT (console_locked_by_current_thread ());
 	write_cnt++;
 	serial_putc (c);
-	vga_putc (c);
+	if (mirror_vga)
+		vga_putc (c);
 }
@@ -7,17 +7,40 @@
 
 #include "hash.h"
 #include "../debug.h"
+#include <string.h>
 #include "threads/malloc.h"
 
-#define list_elem_to_hash_elem(LIST_ELEM)                       \
-	list_entry(LIST_ELEM, struct hash_elem, list_elem)
-
-static struct list *find_bucket (struct hash *, struct hash_elem *);
-static struct hash_elem *find_elem (struct hash *, struct list *,
-		struct hash_elem *);
-static void insert_elem (struct hash *, struct list *, struct hash_elem *);
-static void remove_elem (struct hash *, struct hash_elem *);
-static void rehash (struct hash *);
+/* Table sizes and load factors. */
+#define MIN_SLOTS 8             /* Smallest slot array. */
+#define MAX_LOAD(SLOTS) ((SLOTS) / 4 * 3) /* Grow beyond 3/4 full. */
+#define MIN_LOAD(SLOTS) ((SLOTS) / 8)     /* Shrink below 1/8 full. */
+
+/* Number of slots of the old array moved by each insertion or
+   deletion while resizing, per slot of the current array it
+   replaces.  When growing, the old array holds at most 3/4 as many
+   elements as it has slots and the new one is at least twice as
+   big, so at this rate the old array is empty long before the new
+   one needs to grow in turn.  When shrinking, the old array is
+   larger and more is moved per operation, in proportion. */
+#define MOVE_SLOTS 8
+
+/* Returned by find_slot() when there is no such element. */
+#define NO_SLOT SIZE_MAX
+
+static uint64_t scramble (uint64_t hash);
+static bool table_init (struct hash_table *, size_t slot_cnt);
+static void table_free (struct hash_table *);
+static size_t find_slot (struct hash *, struct hash_table *,
+		struct hash_elem *, uint64_t hash);
+static struct hash_elem *find_elem (struct hash *, struct hash_elem *,
+		uint64_t hash, struct hash_table **, size_t *idx);
+static void table_insert (struct hash_table *, struct hash_elem *,
+		uint64_t hash);
+static void table_remove (struct hash_table *, size_t idx);
+static void insert_elem (struct hash *, struct hash_elem *, uint64_t hash);
+static struct hash_elem **overflow_link (struct hash *, struct hash_elem *);
+static void move_slots (struct hash *);
+static void resize (struct hash *);
 
 /* Initializes hash table H to compute hash values using HASH and
    compare hash elements using LESS, given auxiliary data AUX. */
@@ -25,26 +48,22 @@ static void rehash (struct hash *);
 	Pintos는 힙 영역이 존재하지 않음, 하지만 malloc으로 할당 받으면 힙 영역에 저장되는 것 아닌가?
 	malloc()에 들어가보면 palloc_get_multiple()을 통해 물리 메모리를 할당함
 
-	buckets은 배열이기 때문에, 크기를 미리 알아야 함
-	-> malloc을 통해 bucket_cnt 값이 변함에 따라 동적으로 크기를 초기화 한다는 의미
+	slot 배열은 크기를 미리 알아야 함
+	-> 원소 수가 변함에 따라 새 배열을 malloc으로 할당하고 원소를 조금씩 옮긴다는 의미
 */
 bool
 hash_init (struct hash *h,
 		hash_hash_func *hash, hash_less_func *less, void *aux) {
 	h->elem_cnt = 0;
-	h->bucket_cnt = 4;
-	h->buckets = malloc (sizeof *h->buckets * h->bucket_cnt);
+	h->old.slots = NULL;
+	h->old.slot_cnt = h->old.elem_cnt = 0;
+	h->move_idx = 0;
+	h->overflow = NULL;
 	h->hash = hash;
 	h->less = less;
 	h->aux = aux;
 
-	if (h->buckets != NULL) {
-		hash_clear (h, NULL);
-		return true;
-
-	} else {
-		return false;
-	}
+	return table_init (&h->cur, MIN_SLOTS);
 }
 
 /* Removes all the elements from H.
@@ -58,21 +77,15 @@ hash_init (struct hash *h,
    whether done in DESTRUCTOR or elsewhere. */
 void
 hash_clear (struct hash *h, hash_action_func *destructor) {
-	size_t i;
-
-	for (i = 0; i < h->bucket_cnt; i++) {
-		struct list *bucket = &h->buckets[i];
-
-		if (destructor != NULL)
-			while (!list_empty (bucket)) {
-				struct list_elem *list_elem = list_pop_front (bucket);
-				struct hash_elem *hash_elem = list_elem_to_hash_elem (list_elem);
-				destructor (hash_elem, h->aux);
-			}
-
-		list_init (bucket);
-	}
-
+	if (destructor != NULL)
+		hash_apply (h, destructor);
+
+	table_free (&h->old);
+	h->move_idx = 0;
+	if (h->cur.slots != NULL)
+		memset (h->cur.slots, 0, sizeof *h->cur.slots * h->cur.slot_cnt);
+	h->cur.elem_cnt = 0;
+	h->overflow = NULL;
 	h->elem_cnt = 0;
 }
 
@@ -90,7 +103,8 @@ void
 hash_destroy (struct hash *h, hash_action_func *destructor) {
 	if (destructor != NULL)
 		hash_clear (h, destructor);
-	free (h->buckets);
+	table_free (&h->old);
+	table_free (&h->cur);
 }
 
 /* Inserts NEW into hash table H and returns a null pointer, if
@@ -99,13 +113,11 @@ hash_destroy (struct hash *h, hash_action_func *destructor) {
    without inserting NEW. */
 struct hash_elem *
 hash_insert (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
+	uint64_t hash = scramble (h->hash (new, h->aux));
+	struct hash_elem *old = find_elem (h, new, hash, NULL, NULL);
 
 	if (old == NULL)
-		insert_elem (h, bucket, new);
-
-	rehash (h);
+		insert_elem (h, new, hash);
 
 	return old;
 }
@@ -114,14 +126,20 @@ hash_insert (struct hash *h, struct hash_elem *new) {
    already in the table, which is returned. */
 struct hash_elem *
 hash_replace (struct hash *h, struct hash_elem *new) {
-	struct list *bucket = find_bucket (h, new);
-	struct hash_elem *old = find_elem (h, bucket, new);
-
-	if (old != NULL)
-		remove_elem (h, old);
-	insert_elem (h, bucket, new);
-
-	rehash (h);
+	uint64_t hash = scramble (h->hash (new, h->aux));
+	struct hash_table *table;
+	size_t idx;
+	struct hash_elem *old = find_elem (h, new, hash, &table, &idx);
+
+	/* An equal element has the same hash, so NEW can simply take
+	   over its slot. */
+	if (old != NULL && table != NULL)
+		table->slots[idx].elem = new;
+	else if (old != NULL) {
+		new->next = old->next;
+		*overflow_link (h, old) = new;
+	} else
+		insert_elem (h, new, hash);
 
 	return old;
 }
@@ -133,7 +151,7 @@ hash_replace (struct hash *h, struct hash_elem *new) {
 */
 struct hash_elem *
 hash_find (struct hash *h, struct hash_elem *e) {
-	return find_elem (h, find_bucket (h, e), e);
+	return find_elem (h, e, scramble (h->hash (e, h->aux)), NULL, NULL);
 }
 
 /* Finds, removes, and returns an element equal to E in hash
@@ -145,10 +163,19 @@ hash_find (struct hash *h, struct hash_elem *e) {
    responsibility to deallocate them. */
 struct hash_elem *
 hash_delete (struct hash *h, struct hash_elem *e) {
-	struct hash_elem *found = find_elem (h, find_bucket (h, e), e);
+	struct hash_table *table;
+	size_t idx;
+	struct hash_elem *found = find_elem (h, e, scramble (h->hash (e, h->aux)),
+			&table, &idx);
+
 	if (found != NULL) {
-		remove_elem (h, found);
-		rehash (h);
+		if (table != NULL)
+			table_remove (table, idx);
+		else
+			*overflow_link (h, found) = found->next;
+		h->elem_cnt--;
+		move_slots (h);
+		resize (h);
 	}
 	return found;
 }
@@ -161,18 +188,23 @@ hash_delete (struct hash *h, struct hash_elem *e) {
    undefined behavior, whether done from ACTION or elsewhere. */
 void
 hash_apply (struct hash *h, hash_action_func *action) {
-	size_t i;
+	struct hash_table *tables[2] = {&h->old, &h->cur};
+	struct hash_elem *e, *next;
+	size_t i, j;
 
 	ASSERT (action != NULL);
 
-	for (i = 0; i < h->bucket_cnt; i++) {
-		struct list *bucket = &h->buckets[i];
-		struct list_elem *elem, *next;
-
-		for (elem = list_begin (bucket); elem != list_end (bucket); elem = next) {
-			next = list_next (elem);
-			action (list_elem_to_hash_elem (elem), h->aux);
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < tables[i]->slot_cnt; j++) {
+			e = tables[i]->slots[j].elem;
+			if (e != NULL)
+				action (e, h->aux);
 		}
+
+	/* ACTION may free E. */
+	for (e = h->overflow; e != NULL; e = next) {
+		next = e->next;
+		action (e, h->aux);
 	}
 }
 
@@ -199,8 +231,9 @@ hash_first (struct hash_iterator *i, struct hash *h) {
 	ASSERT (h != NULL);
 
 	i->hash = h;
-	i->bucket = i->hash->buckets;
-	i->elem = list_elem_to_hash_elem (list_head (i->bucket));
+	i->table = &h->old;
+	i->idx = 0;
+	i->elem = NULL;
 }
 
 /* Advances I to the next element in the hash table and returns
@@ -215,16 +248,21 @@ struct hash_elem *
 hash_next (struct hash_iterator *i) {
 	ASSERT (i != NULL);
 
-	i->elem = list_elem_to_hash_elem (list_next (&i->elem->list_elem));
-	while (i->elem == list_elem_to_hash_elem (list_end (i->bucket))) {
-		if (++i->bucket >= i->hash->buckets + i->hash->bucket_cnt) {
-			i->elem = NULL;
-			break;
+	for (;;) {
+		if (i->table == NULL)
+			return i->elem = i->elem != NULL ? i->elem->next : NULL;
+		while (i->idx < i->table->slot_cnt) {
+			struct hash_elem *e = i->table->slots[i->idx++].elem;
+			if (e != NULL)
+				return i->elem = e;
 		}
-		i->elem = list_elem_to_hash_elem (list_begin (i->bucket));
+		if (i->table == &i->hash->cur) {
+			i->table = NULL;
+			return i->elem = i->hash->overflow;
+		}
+		i->table = &i->hash->cur;
+		i->idx = 0;
 	}
-
-	return i->elem;
 }
 
 /* Returns the current element in the hash table iteration, or a
@@ -247,160 +285,326 @@ hash_empty (struct hash *h) {
 	return h->elem_cnt == 0;
 }
 
-/* Fowler-Noll-Vo hash constants, for 32-bit word sizes. */
-#define FNV_64_PRIME 0x00000100000001B3UL
-#define FNV_64_BASIS 0xcbf29ce484222325UL
+/* Constants from the 64-bit finalizer of MurmurHash3. */
+#define MIX_MUL1 0xff51afd7ed558ccdULL
+#define MIX_MUL2 0xc4ceb9fe1a85ec53ULL
+
+/* Returns X with its bits thoroughly mixed, so that every input
+   bit affects every output bit. */
+static inline uint64_t
+mix64 (uint64_t x) {
+	x ^= x >> 33;
+	x *= MIX_MUL1;
+	x ^= x >> 33;
+	x *= MIX_MUL2;
+	x ^= x >> 33;
+	return x;
+}
+
+/* Returns X rotated left by N bits. */
+static inline uint64_t
+rotl64 (uint64_t x, int n) {
+	return (x << n) | (x >> (64 - n));
+}
 
 /* Returns a hash of the SIZE bytes in BUF. */
 uint64_t
 hash_bytes (const void *buf_, size_t size) {
-	/* Fowler-Noll-Vo 32-bit hash, for bytes. */
+	/* Combines the input 8 bytes at a time, multiplying and
+	   rotating each word in, then mixes the result.  Much faster
+	   than a byte-at-a-time hash such as FNV for all but the
+	   shortest keys, with better distribution in the low bits. */
+	typedef uint64_t __attribute__ ((may_alias, aligned (1))) word_t;
 	const unsigned char *buf = buf_;
-	uint64_t hash;
+	uint64_t hash = size * MIX_MUL2;
+	uint64_t tail = 0;
 
 	ASSERT (buf != NULL);
 
-	hash = FNV_64_BASIS;
+	for (; size >= 8; buf += 8, size -= 8)
+		hash = rotl64 (hash ^ (*(const word_t *) buf * MIX_MUL1), 31) * MIX_MUL2;
 	while (size-- > 0)
-		hash = (hash * FNV_64_PRIME) ^ *buf++;
+		tail = (tail << 8) | buf[size];
+	hash ^= tail * MIX_MUL1;
 
-	return hash;
+	return mix64 (hash);
 }
 
 /* Returns a hash of string S. */
 uint64_t
-hash_string (const char *s_) {
-	const unsigned char *s = (const unsigned char *) s_;
-	uint64_t hash;
-
+hash_string (const char *s) {
 	ASSERT (s != NULL);
 
-	hash = FNV_64_BASIS;
-	while (*s != '\0')
-		hash = (hash * FNV_64_PRIME) ^ *s++;
-
-	return hash;
+	return hash_bytes (s, strlen (s));
 }
 
 /* Returns a hash of integer I. */
 uint64_t
 hash_int (int i) {
-	return hash_bytes (&i, sizeof i);
-}
-
-/* Returns the bucket in H that E belongs in. */
-static struct list *
-find_bucket (struct hash *h, struct hash_elem *e) {
-	size_t bucket_idx = h->hash (e, h->aux) & (h->bucket_cnt - 1);
-	return &h->buckets[bucket_idx];
+	return mix64 ((unsigned) i);
 }
 
-/* Searches BUCKET in H for a hash element equal to E.  Returns
-   it if found or a null pointer otherwise. */
-static struct hash_elem *
-find_elem (struct hash *h, struct list *bucket, struct hash_elem *e) {
-	struct list_elem *i;
-
-	for (i = list_begin (bucket); i != list_end (bucket); i = list_next (i)) {
-		struct hash_elem *hi = list_elem_to_hash_elem (i);
-		if (!h->less (hi, e, h->aux) && !h->less (e, hi, h->aux))
-			return hi;
-	}
-	return NULL;
+/* Returns HASH, a value from the table's hash function,
+   multiplied by 2**64 divided by the golden ratio.  Home slots
+   come from the top bits of the product, which depend on every
+   bit of HASH, so even a poor hash function that leaves the low
+   bits constant spreads its elements over the table.  The
+   multiplier is odd, so distinct hashes stay distinct. */
+static uint64_t
+scramble (uint64_t hash) {
+	return hash * 0x9e3779b97f4a7c15ULL;
 }
 
-/* Returns X with its lowest-order bit set to 1 turned off. */
+/* Returns the home slot of scrambled hash value HASH in T. */
 static inline size_t
-turn_off_least_1bit (size_t x) {
-	return x & (x - 1);
+home_slot (const struct hash_table *t, uint64_t hash) {
+	return hash >> t->shift;
 }
 
-/* Returns true if X is a power of 2, otherwise false. */
+/* Returns how far slot IDX in T, holding scrambled hash value
+   HASH, is from its home slot. */
 static inline size_t
-is_power_of_2 (size_t x) {
-	return x != 0 && turn_off_least_1bit (x) == 0;
+probe_dist (const struct hash_table *t, uint64_t hash, size_t idx) {
+	return (idx - home_slot (t, hash)) & (t->slot_cnt - 1);
 }
 
-/* Element per bucket ratios. */
-#define MIN_ELEMS_PER_BUCKET  1 /* Elems/bucket < 1: reduce # of buckets. */
-#define BEST_ELEMS_PER_BUCKET 2 /* Ideal elems/bucket. */
-#define MAX_ELEMS_PER_BUCKET  4 /* Elems/bucket > 4: increase # of buckets. */
+/* Initializes T as an empty array of SLOT_CNT slots, which must
+   be a power of 2.  Returns false if out of memory. */
+static bool
+table_init (struct hash_table *t, size_t slot_cnt) {
+	int shift = 64;
+	size_t n;
+
+	ASSERT (slot_cnt >= 2 && (slot_cnt & (slot_cnt - 1)) == 0);
+
+	t->slots = calloc (slot_cnt, sizeof *t->slots);
+	if (t->slots == NULL)
+		return false;
+	for (n = slot_cnt; n > 1; n >>= 1)
+		shift--;
+	t->slot_cnt = slot_cnt;
+	t->elem_cnt = 0;
+	t->shift = shift;
+	return true;
+}
 
-/* Changes the number of buckets in hash table H to match the
-   ideal.  This function can fail because of an out-of-memory
-   condition, but that'll just make hash accesses less efficient;
-   we can still continue. */
+/* Frees T's slots, leaving it empty. */
 static void
-rehash (struct hash *h) {
-	size_t old_bucket_cnt, new_bucket_cnt;
-	struct list *new_buckets, *old_buckets;
-	size_t i;
+table_free (struct hash_table *t) {
+	free (t->slots);
+	t->slots = NULL;
+	t->slot_cnt = t->elem_cnt = 0;
+}
 
-	ASSERT (h != NULL);
+/* Searches T in H for an element equal to E, whose scrambled hash
+   value is HASH.  Returns its slot index if found or NO_SLOT
+   otherwise. */
+static size_t
+find_slot (struct hash *h, struct hash_table *t, struct hash_elem *e,
+		uint64_t hash) {
+	size_t mask = t->slot_cnt - 1;
+	size_t idx, dist;
+
+	if (t->elem_cnt == 0)
+		return NO_SLOT;
+
+	/* Robin Hood order means that every element between E's home
+	   slot and E is at least as far from its own home as E would
+	   be, so the search can stop at the first one that isn't. */
+	for (idx = home_slot (t, hash), dist = 0; ; idx = (idx + 1) & mask, dist++) {
+		struct hash_slot *s = &t->slots[idx];
+
+		if (s->elem == NULL || probe_dist (t, s->hash, idx) < dist)
+			return NO_SLOT;
+		if (s->hash == hash
+				&& !h->less (s->elem, e, h->aux) && !h->less (e, s->elem, h->aux))
+			return idx;
+	}
+}
 
-	/* Save old bucket info for later use. */
-	old_buckets = h->buckets;
-	old_bucket_cnt = h->bucket_cnt;
-
-	/* Calculate the number of buckets to use now.
-	   We want one bucket for about every BEST_ELEMS_PER_BUCKET.
-	   We must have at least four buckets, and the number of
-	   buckets must be a power of 2. */
-	new_bucket_cnt = h->elem_cnt / BEST_ELEMS_PER_BUCKET;
-	if (new_bucket_cnt < 4)
-		new_bucket_cnt = 4;
-	while (!is_power_of_2 (new_bucket_cnt))
-		new_bucket_cnt = turn_off_least_1bit (new_bucket_cnt);
-
-	/* Don't do anything if the bucket count wouldn't change. */
-	if (new_bucket_cnt == old_bucket_cnt)
-		return;
+/* Searches H for an element equal to E, whose scrambled hash
+   value is HASH.  Returns it if found or a null pointer
+   otherwise.  If found and TABLE and IDX are nonnull, stores its
+   location in *TABLE and *IDX, or a null *TABLE if it is in the
+   overflow list. */
+static struct hash_elem *
+find_elem (struct hash *h, struct hash_elem *e, uint64_t hash,
+		struct hash_table **table, size_t *idx) {
+	struct hash_table *t = &h->cur;
+	size_t i = find_slot (h, t, e, hash);
+
+	if (i == NO_SLOT) {
+		t = &h->old;
+		i = find_slot (h, t, e, hash);
+	}
+	if (i == NO_SLOT) {
+		struct hash_elem *o;
+
+		for (o = h->overflow; o != NULL; o = o->next)
+			if (!h->less (o, e, h->aux) && !h->less (e, o, h->aux))
+				break;
+		if (o != NULL && table != NULL) {
+			*table = NULL;
+			*idx = 0;
+		}
+		return o;
+	}
 
-	/* Allocate new buckets and initialize them as empty. */
-	new_buckets = malloc (sizeof *new_buckets * new_bucket_cnt);
-	if (new_buckets == NULL) {
-		/* Allocation failed.  This means that use of the hash table will
-		   be less efficient.  However, it is still usable, so
-		   there's no reason for it to be an error. */
-		return;
+	if (table != NULL) {
+		*table = t;
+		*idx = i;
 	}
-	for (i = 0; i < new_bucket_cnt; i++)
-		list_init (&new_buckets[i]);
-
-	/* Install new bucket info. */
-	h->buckets = new_buckets;
-	h->bucket_cnt = new_bucket_cnt;
-
-	/* Move each old element into the appropriate new bucket. */
-	for (i = 0; i < old_bucket_cnt; i++) {
-		struct list *old_bucket;
-		struct list_elem *elem, *next;
-
-		old_bucket = &old_buckets[i];
-		for (elem = list_begin (old_bucket);
-				elem != list_end (old_bucket); elem = next) {
-			struct list *new_bucket
-				= find_bucket (h, list_elem_to_hash_elem (elem));
-			next = list_next (elem);
-			list_remove (elem);
-			list_push_front (new_bucket, elem);
+	return t->slots[i].elem;
+}
+
+/* Inserts E, with scrambled hash value HASH, into T, which must
+   have a free slot. */
+static void
+table_insert (struct hash_table *t, struct hash_elem *e, uint64_t hash) {
+	size_t mask = t->slot_cnt - 1;
+	struct hash_slot new = {hash, e};
+	size_t idx, dist;
+
+	ASSERT (t->elem_cnt < t->slot_cnt);
+
+	/* Whenever the element being placed is farther from home than
+	   a slot's occupant, it takes the slot and the occupant moves
+	   on instead. */
+	for (idx = home_slot (t, hash), dist = 0; ; idx = (idx + 1) & mask, dist++) {
+		struct hash_slot *s = &t->slots[idx];
+		size_t s_dist;
+
+		if (s->elem == NULL) {
+			*s = new;
+			break;
+		}
+
+		s_dist = probe_dist (t, s->hash, idx);
+		if (s_dist < dist) {
+			struct hash_slot tmp = *s;
+			*s = new;
+			new = tmp;
+			dist = s_dist;
 		}
 	}
+	t->elem_cnt++;
+}
 
-	free (old_buckets);
+/* Empties slot IDX of T, shifting the elements after it back by
+   one slot until one that is already home, so that no searches
+   are cut short and no tombstones are needed. */
+static void
+table_remove (struct hash_table *t, size_t idx) {
+	size_t mask = t->slot_cnt - 1;
+	size_t next;
+
+	for (next = (idx + 1) & mask;
+			t->slots[next].elem != NULL
+			&& probe_dist (t, t->slots[next].hash, next) > 0;
+			idx = next, next = (next + 1) & mask)
+		t->slots[idx] = t->slots[next];
+	t->slots[idx].elem = NULL;
+	t->elem_cnt--;
 }
 
-/* Inserts E into BUCKET (in hash table H). */
+/* Inserts E, with scrambled hash value HASH, into H. */
 static void
-insert_elem (struct hash *h, struct list *bucket, struct hash_elem *e) {
+insert_elem (struct hash *h, struct hash_elem *e, uint64_t hash) {
+	move_slots (h);
+	resize (h);
+
+	/* If no larger array could be allocated, the current one fills
+	   up further, but one slot always stays empty so that searches
+	   terminate.  Past that, E goes on the overflow list, which
+	   needs no memory of its own, until a later resize succeeds
+	   and takes it in.  Either way the insertion succeeds. */
+	if (h->cur.elem_cnt + 1 < h->cur.slot_cnt)
+		table_insert (&h->cur, e, hash);
+	else {
+		e->next = h->overflow;
+		h->overflow = e;
+	}
 	h->elem_cnt++;
-	list_push_front (bucket, &e->list_elem);
 }
 
-/* Removes E from hash table H. */
+/* Returns the link in H's overflow list that points to E, which
+   must be in the list. */
+static struct hash_elem **
+overflow_link (struct hash *h, struct hash_elem *e) {
+	struct hash_elem **link;
+
+	for (link = &h->overflow; *link != e; link = &(*link)->next)
+		ASSERT (*link != NULL);
+	return link;
+}
+
+/* While H is being resized, moves the elements in the next few
+   slots of the old array into the current one, freeing the old
+   array once it is empty. */
 static void
-remove_elem (struct hash *h, struct hash_elem *e) {
-	h->elem_cnt--;
-	list_remove (&e->list_elem);
+move_slots (struct hash *h) {
+	struct hash_table *old = &h->old;
+	size_t cnt;
+
+	if (old->slots == NULL)
+		return;
+
+	cnt = MOVE_SLOTS;
+	if (old->slot_cnt > h->cur.slot_cnt)
+		cnt *= old->slot_cnt / h->cur.slot_cnt;
+
+	/* Slots before MOVE_IDX are all empty, so removing an element
+	   never shifts another one back into them. */
+	while (cnt-- > 0 && h->move_idx < old->slot_cnt) {
+		struct hash_slot *s = &old->slots[h->move_idx];
+
+		if (s->elem != NULL) {
+			table_insert (&h->cur, s->elem, s->hash);
+			table_remove (old, h->move_idx);
+		} else
+			h->move_idx++;
+	}
+
+	if (h->move_idx == old->slot_cnt) {
+		ASSERT (old->elem_cnt == 0);
+		table_free (old);
+		h->move_idx = 0;
+	}
 }
 
+/* Starts resizing H if its current array is too full or too
+   empty, or elements are waiting in the overflow list, unless a
+   resize is already under way.  The new array is sized for the
+   load to be about half, and takes in the overflow list at once.
+   This function can fail because of an out-of-memory condition,
+   but that'll just leave the table fuller or emptier than it
+   should be, and it is tried again on the next insertion or
+   deletion. */
+static void
+resize (struct hash *h) {
+	struct hash_table new;
+	size_t slot_cnt;
+
+	if (h->old.slots != NULL)
+		return;
+	if (h->cur.elem_cnt < MAX_LOAD (h->cur.slot_cnt)
+			&& (h->cur.elem_cnt >= MIN_LOAD (h->cur.slot_cnt)
+				|| h->cur.slot_cnt <= MIN_SLOTS)
+			&& h->overflow == NULL)
+		return;
+
+	for (slot_cnt = MIN_SLOTS; slot_cnt < h->elem_cnt * 2; slot_cnt *= 2)
+		continue;
+	if (slot_cnt == h->cur.slot_cnt || !table_init (&new, slot_cnt))
+		return;
+
+	h->old = h->cur;
+	h->cur = new;
+	h->move_idx = 0;
+
+	while (h->overflow != NULL) {
+		struct hash_elem *e = h->overflow;
+		h->overflow = e->next;
+		table_insert (&h->cur, e, scramble (h->hash (e, h->aux)));
+	}
+}
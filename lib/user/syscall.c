@@ -60,7 +60,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -96,6 +96,11 @@ exec (const char *file) {
 	return (pid_t) syscall1 (SYS_EXEC, file);
 }
 
+pid_t
+spawn (const char *cmd_line, const struct spawn_fd *fd_actions, size_t fd_cnt) {
+	return (pid_t) syscall3 (SYS_SPAWN, cmd_line, fd_actions, fd_cnt);
+}
+
 int
 wait (pid_t pid) {
 	return syscall1 (SYS_WAIT, pid);
@@ -200,3 +205,43 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+trace_dump (int fd) {
+	return syscall1 (SYS_TRACE_DUMP, fd);
+}
+
+int
+clock_gettime (int clock_id, struct timespec *ts) {
+	return syscall2 (SYS_CLOCK_GETTIME, clock_id, ts);
+}
+
+int
+syscall_stats (int scope, struct syscall_stat *stats, int cnt) {
+	return syscall3 (SYS_SYSCALL_STATS, scope, stats, cnt);
+}
+
+int
+io_ring_enter (struct io_ring *ring) {
+	return syscall1 (SYS_IO_RING_ENTER, ring);
+}
+
+int
+pread (int fd, void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PREAD, fd, buffer, size, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	return syscall4 (SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt) {
+	return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
@@ -0,0 +1,8 @@
+/* Writes out the content of a fairly large file in random order and
+   reads it back in random order with pwrite() and pread(), then
+   writes and reads the whole file with one writev() and one
+   readv(), counting the file I/O system calls each pass makes. */
+
+#define BLOCK_SIZE 512
+#define TEST_SIZE (512 * 150)
+#include "tests/filesys/base/random-pio.inc"
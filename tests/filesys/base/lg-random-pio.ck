@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'CKEOF']);
+(lg-random-pio) begin
+(lg-random-pio) create "bazzle"
+(lg-random-pio) open "bazzle"
+(lg-random-pio) write "bazzle" in random order with 150 calls
+(lg-random-pio) read "bazzle" in random order with 150 calls
+(lg-random-pio) gather-write "bazzle" with 1 calls
+(lg-random-pio) scatter-read "bazzle" with 1 calls
+(lg-random-pio) close "bazzle"
+(lg-random-pio) end
+CKEOF
+pass;
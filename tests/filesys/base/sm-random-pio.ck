@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'CKEOF']);
+(sm-random-pio) begin
+(sm-random-pio) create "bazzle"
+(sm-random-pio) open "bazzle"
+(sm-random-pio) write "bazzle" in random order with 123 calls
+(sm-random-pio) read "bazzle" in random order with 123 calls
+(sm-random-pio) gather-write "bazzle" with 1 calls
+(sm-random-pio) scatter-read "bazzle" with 1 calls
+(sm-random-pio) close "bazzle"
+(sm-random-pio) end
+CKEOF
+pass;
@@ -0,0 +1,131 @@
+/* Measures the hash table in lib/kernel/hash.c at sizes from 1k
+   to 1M elements.  For each size, reports the average cycles per
+   insertion, successful and unsuccessful lookup, and deletion,
+   along with the slowest single insertion, which shows whether
+   growing the table stalls any one caller.  Sizes that do not fit
+   in kernel memory are skipped. */
+
+#include <hash.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "intrinsic.h"
+
+struct item
+  {
+    uint64_t key;
+    struct hash_elem elem;
+  };
+
+static uint64_t
+item_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct item *it = hash_entry (e, struct item, elem);
+  return hash_bytes (&it->key, sizeof it->key);
+}
+
+static bool
+item_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED)
+{
+  return hash_entry (a, struct item, elem)->key
+         < hash_entry (b, struct item, elem)->key;
+}
+
+/* Returns the Ith key.  Keys are spread out like addresses so
+   that they are not trivially sequential. */
+static uint64_t
+key_of (size_t i)
+{
+  return (uint64_t) i * 4096 + 0x400000;
+}
+
+/* Looks up the keys I, for I in [FIRST, FIRST + CNT), in H, and
+   fails unless each is found exactly when EXPECT says so.
+   Returns the cycles taken. */
+static uint64_t
+lookup_all (struct hash *h, size_t first, size_t cnt, bool expect)
+{
+  struct item key;
+  uint64_t start = rdtsc ();
+  size_t i;
+
+  for (i = first; i < first + cnt; i++)
+    {
+      key.key = key_of (i);
+      if ((hash_find (h, &key.elem) != NULL) != expect)
+        fail ("lookup of key %zu went wrong", i);
+    }
+  return rdtsc () - start;
+}
+
+static void
+bench (size_t n)
+{
+  struct item *items;
+  struct hash h;
+  uint64_t start, insert, max_insert = 0, hit, miss, delete;
+  void *room;
+  size_t i;
+
+  /* At its largest, while growing, the table needs the old slot
+     array and one twice as big: 3 slots of 16 bytes for every
+     element at worst.  Make sure that much memory is free. */
+  items = malloc (n * sizeof *items);
+  room = malloc (n * 3 * 16);
+  if (items == NULL || room == NULL)
+    {
+      msg ("%7zu elements: skipped, out of memory", n);
+      free (items);
+      free (room);
+      return;
+    }
+  free (room);
+  if (!hash_init (&h, item_hash, item_less, NULL))
+    fail ("hash_init failed");
+
+  insert = 0;
+  for (i = 0; i < n; i++)
+    {
+      uint64_t t;
+
+      items[i].key = key_of (i);
+      start = rdtsc ();
+      if (hash_insert (&h, &items[i].elem) != NULL)
+        fail ("duplicate key %zu", i);
+      t = rdtsc () - start;
+      insert += t;
+      if (t > max_insert)
+        max_insert = t;
+    }
+  if (hash_size (&h) != n)
+    fail ("table holds %zu elements, expected %zu", hash_size (&h), n);
+
+  hit = lookup_all (&h, 0, n, true);
+  miss = lookup_all (&h, n, n, false);
+
+  start = rdtsc ();
+  for (i = 0; i < n; i++)
+    if (hash_delete (&h, &items[i].elem) != &items[i].elem)
+      fail ("deleting key %zu went wrong", i);
+  delete = rdtsc () - start;
+  if (!hash_empty (&h))
+    fail ("table not empty after deleting everything");
+
+  msg ("%7zu elements: insert %llu, hit %llu, miss %llu, delete %llu "
+       "cycles/op; slowest insert %llu cycles",
+       n, insert / n, hit / n, miss / n, delete / n, max_insert);
+
+  hash_destroy (&h, NULL);
+  free (items);
+}
+
+void
+test_hash_bench (void) 
+{
+  size_t n;
+
+  for (n = 1000; n <= 1000000; n *= 10)
+    bench (n);
+  pass ();
+}
@@ -0,0 +1,30 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle counts vary from run to run.
+s/: insert \d+, hit \d+, miss \d+, delete \d+ cycles\/op; slowest insert \d+ cycles$/: insert C, hit C, miss C, delete C cycles\/op; slowest insert C cycles/
+  foreach @output;
+
+# The largest tables are skipped when memory runs short, so the
+# first 1 to 4 sizes are measured and the rest skipped.
+my (@sizes) = (1000, 10000, 100000, 1000000);
+my (@expected);
+for my $measured (1...@sizes) {
+    push (@expected, join ("\n",
+	"(hash-bench) begin",
+	(map (sprintf ("(hash-bench) %7d elements: insert C, hit C, miss C, "
+		       . "delete C cycles/op; slowest insert C cycles", $_),
+	      @sizes[0...$measured - 1])),
+	(map (sprintf ("(hash-bench) %7d elements: skipped, out of memory", $_),
+	      @sizes[$measured...$#sizes])),
+	"(hash-bench) PASS",
+	"(hash-bench) end"));
+}
+compare_output ("run", \@output, \@expected);
+pass;
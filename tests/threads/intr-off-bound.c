@@ -0,0 +1,91 @@
+/* Runs a mix of sleeping, semaphore ping-pong and lock traffic
+   with interrupts-off profiling on, then fails if interrupts
+   stayed off longer than the bound given by -intr-bound (one
+   timer tick by default). */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPERS 8
+#define ROUNDS 50
+
+static struct semaphore ping, pong, done;
+static struct lock lock;
+static int counter;
+
+static int sleeper_ids[SLEEPERS];
+
+static void
+sleeper (void *id_)
+{
+  int *id = id_;
+  int round;
+
+  for (round = 0; round < ROUNDS / (*id + 1); round++)
+    timer_sleep (*id + 1);
+  sema_up (&done);
+}
+
+static void
+ponger (void *aux UNUSED)
+{
+  int round;
+
+  for (round = 0; round < ROUNDS * 20; round++)
+    {
+      sema_down (&ping);
+      lock_acquire (&lock);
+      counter++;
+      lock_release (&lock);
+      sema_up (&pong);
+    }
+  sema_up (&done);
+}
+
+void
+test_intr_off_bound (void) 
+{
+  int64_t longest;
+  int i;
+
+  sema_init (&ping, 0);
+  sema_init (&pong, 0);
+  sema_init (&done, 0);
+  lock_init (&lock);
+
+  intr_prof_reset ();
+  for (i = 0; i < SLEEPERS; i++)
+    {
+      char name[16];
+      sleeper_ids[i] = i;
+      snprintf (name, sizeof name, "sleeper %d", i);
+      thread_create (name, PRI_DEFAULT, sleeper, &sleeper_ids[i]);
+    }
+  thread_create ("ponger", PRI_DEFAULT, ponger, NULL);
+
+  for (i = 0; i < ROUNDS * 20; i++)
+    {
+      sema_up (&ping);
+      lock_acquire (&lock);
+      counter++;
+      lock_release (&lock);
+      sema_down (&pong);
+    }
+  for (i = 0; i < SLEEPERS + 1; i++)
+    sema_down (&done);
+
+  longest = intr_prof_longest ();
+  if (longest > intr_prof_bound)
+    {
+      intr_print_stats ();
+      fail ("interrupts stayed off for %lld us, bound is %d us",
+            longest, intr_prof_bound);
+    }
+  msg ("interrupts-off sections within bound");
+  pass ();
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(intr-off-bound) begin
+(intr-off-bound) interrupts-off sections within bound
+(intr-off-bound) PASS
+(intr-off-bound) end
+EOF
+pass;
@@ -0,0 +1,43 @@
+/* Checks the contention statistics of a named lock.  The main
+   thread holds the lock while a higher-priority thread blocks on
+   it, so of the two acquisitions exactly one is contended. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static struct lock lock;
+
+static void
+acquire_thread (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  lock_release (&lock);
+}
+
+void
+test_lock_stats (void) 
+{
+  struct lock_stats *s;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init_named (&lock, "lock-stats");
+  s = lock.stats;
+  if (s == NULL)
+    fail ("lock has no statistics");
+
+  lock_acquire (&lock);
+  thread_create ("acquire", PRI_DEFAULT + 1, acquire_thread, NULL);
+  lock_release (&lock);
+
+  msg ("%llu acquires, %llu contended", s->acquire_cnt, s->contended_cnt);
+  if (s->wait_max == 0 || s->wait_total < s->wait_max)
+    fail ("wait time not recorded");
+  if (s->hold_max == 0 || s->hold_total < s->hold_max)
+    fail ("hold time not recorded");
+  pass ();
+}
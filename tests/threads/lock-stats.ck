@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(lock-stats) begin
+(lock-stats) 2 acquires, 1 contended
+(lock-stats) PASS
+(lock-stats) end
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* The main thread holds an rwlock for reading.  A higher-priority
+   writer blocks on it, then an even higher-priority reader, which
+   must wait behind the writer.  Both donate to the main thread.
+   When the main thread releases the rwlock, the writer gets it
+   first, at the waiting reader's priority, and the reader after
+   it. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func writer_thread;
+static thread_func reader_thread;
+
+void
+test_rwlock_donate (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_acquire_read (&rw);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread, &rw);
+  msg ("main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  thread_create ("reader", PRI_DEFAULT + 4, reader_thread, &rw);
+  msg ("main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 4, thread_get_priority ());
+  rwlock_release_read (&rw);
+  msg ("main should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+writer_thread (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_write (rw);
+  msg ("writer: got the lock at priority %d", thread_get_priority ());
+  rwlock_release_write (rw);
+  msg ("writer: done at priority %d", thread_get_priority ());
+}
+
+static void
+reader_thread (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_acquire_read (rw);
+  msg ("reader: got the lock at priority %d", thread_get_priority ());
+  rwlock_release_read (rw);
+  msg ("reader: done");
+}
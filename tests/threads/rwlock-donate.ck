@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-donate) begin
+(rwlock-donate) main should have priority 33.  Actual priority: 33.
+(rwlock-donate) main should have priority 35.  Actual priority: 35.
+(rwlock-donate) writer: got the lock at priority 35
+(rwlock-donate) reader: got the lock at priority 35
+(rwlock-donate) reader: done
+(rwlock-donate) writer: done at priority 33
+(rwlock-donate) main should have priority 31.  Actual priority: 31.
+(rwlock-donate) end
+EOF
+pass;
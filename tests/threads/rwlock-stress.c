@@ -0,0 +1,128 @@
+/* Runs readers and writers of mixed priority against one rwlock,
+   yielding inside and outside their critical sections to force
+   interleavings.  Checks that a writer never overlaps another
+   writer or any reader, and that readers always see a consistent
+   snapshot of the data. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+#define READERS 6
+#define WRITERS 3
+#define ITERS 200
+#define DATA_CNT 8
+
+static struct rwlock rw;
+static int data[DATA_CNT];
+static int active_readers, active_writers;
+static int read_cnt, write_cnt;
+static struct semaphore done;
+
+static void
+check_data (void) 
+{
+  int i;
+
+  for (i = 1; i < DATA_CNT; i++)
+    if (data[i] != data[0])
+      fail ("reader saw a partial write");
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  enum intr_level old_level;
+  int i;
+
+  for (i = 0; i < ITERS; i++)
+    {
+      /* Readers share the lock, so their counters need interrupts
+         off to stay exact. */
+      rwlock_acquire_read (&rw);
+      old_level = intr_disable ();
+      active_readers++;
+      intr_set_level (old_level);
+      if (active_writers != 0)
+        fail ("reader overlaps a writer");
+      check_data ();
+      if (i % 3 == 0)
+        thread_yield ();
+      check_data ();
+      old_level = intr_disable ();
+      read_cnt++;
+      active_readers--;
+      intr_set_level (old_level);
+      rwlock_release_read (&rw);
+      if (i % 5 == 0)
+        thread_yield ();
+    }
+  sema_up (&done);
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  int i, j;
+
+  for (i = 0; i < ITERS; i++)
+    {
+      rwlock_acquire_write (&rw);
+      active_writers++;
+      if (active_writers != 1 || active_readers != 0)
+        fail ("writer overlaps %d writers and %d readers",
+              active_writers - 1, active_readers);
+      for (j = 0; j < DATA_CNT; j++)
+        {
+          data[j]++;
+          if (j == DATA_CNT / 2)
+            thread_yield ();
+        }
+      write_cnt++;
+      active_writers--;
+      rwlock_release_write (&rw);
+      thread_yield ();
+    }
+  sema_up (&done);
+}
+
+void
+test_rwlock_stress (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  rwlock_init (&rw);
+  sema_init (&done, 0);
+  for (i = 0; i < READERS + WRITERS; i++)
+    {
+      char name[16];
+      int priority = PRI_DEFAULT - 1 - i % 3;
+
+      if (i < READERS)
+        {
+          snprintf (name, sizeof name, "reader %d", i);
+          thread_create (name, priority, reader_thread, NULL);
+        }
+      else
+        {
+          snprintf (name, sizeof name, "writer %d", i - READERS);
+          thread_create (name, priority, writer_thread, NULL);
+        }
+    }
+  for (i = 0; i < READERS + WRITERS; i++)
+    sema_down (&done);
+
+  check_data ();
+  msg ("%d reads, %d writes", read_cnt, write_cnt);
+  if (data[0] != WRITERS * ITERS)
+    fail ("data is %d, expected %d", data[0], WRITERS * ITERS);
+  if (thread_get_priority () != PRI_DEFAULT)
+    fail ("main thread kept priority %d", thread_get_priority ());
+  pass ();
+}
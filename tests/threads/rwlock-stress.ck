@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-stress) begin
+(rwlock-stress) 1200 reads, 600 writes
+(rwlock-stress) PASS
+(rwlock-stress) end
+EOF
+pass;
@@ -0,0 +1,100 @@
+/* Measures sema_up() with many waiters of mixed priority.  Blocks
+   WAITERS threads on one semaphore and wakes them one at a time
+   from below all of them, so that each runs as soon as it is woken,
+   checking that they come out highest priority first and, among
+   equal priorities, in the order they started waiting.  Then
+   blocks them all again on a second semaphore and times waking
+   them from above. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+#define WAITERS 256
+
+struct waiter
+  {
+    int priority;
+    int arrival;                /* Order of reaching sema_down(). */
+  };
+
+static struct semaphore sema, bench_sema;
+static struct waiter waiters[WAITERS];
+static int arrived;
+static struct waiter *order[WAITERS];
+static int woken;
+static int finished;
+
+static void
+waiter_thread (void *w_)
+{
+  struct waiter *w = w_;
+
+  w->arrival = arrived++;
+  sema_down (&sema);
+  order[woken++] = w;
+  sema_down (&bench_sema);
+  finished++;
+}
+
+void
+test_sema_bench (void) 
+{
+  uint64_t start, cycles;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  sema_init (&bench_sema, 0);
+  for (i = 0; i < WAITERS; i++)
+    {
+      char name[16];
+
+      waiters[i].priority = PRI_MIN + 1 + (i * 7) % (PRI_DEFAULT - PRI_MIN - 1);
+      snprintf (name, sizeof name, "waiter %d", i);
+      thread_create (name, waiters[i].priority, waiter_thread, &waiters[i]);
+    }
+
+  /* Let every waiter block. */
+  thread_set_priority (PRI_MIN);
+  if (arrived != WAITERS)
+    fail ("only %d of %d threads are waiting", arrived, WAITERS);
+
+  /* Wake them one at a time.  We are below every waiter, so each
+     one preempts us and records itself before the next sema_up(),
+     and ORDER is the order the wait queue gave them up in, not
+     the order the ready list would run them in. */
+  for (i = 0; i < WAITERS; i++)
+    {
+      sema_up (&sema);
+      if (woken != i + 1)
+        fail ("sema_up %d did not run a waiter at once", i);
+    }
+  for (i = 1; i < WAITERS; i++)
+    if (order[i]->priority > order[i - 1]->priority
+        || (order[i]->priority == order[i - 1]->priority
+            && order[i]->arrival < order[i - 1]->arrival))
+      fail ("thread with priority %d woke before priority %d",
+            order[i - 1]->priority, order[i]->priority);
+
+  /* Every waiter is now blocked on BENCH_SEMA.  Wake them all
+     without letting any run yet, for timing only. */
+  thread_set_priority (PRI_MAX);
+  start = rdtsc ();
+  for (i = 0; i < WAITERS; i++)
+    sema_up (&bench_sema);
+  cycles = rdtsc () - start;
+
+  thread_set_priority (PRI_MIN);
+  if (finished != WAITERS)
+    fail ("only %d of %d threads finished", finished, WAITERS);
+
+  thread_set_priority (PRI_DEFAULT);
+  msg ("%d waiters: %llu cycles/sema_up", WAITERS, cycles / WAITERS);
+  pass ();
+}
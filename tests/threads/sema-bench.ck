@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle count varies from run to run.
+s/: \d+ cycles\/sema_up$/: C cycles\/sema_up/ foreach @output;
+
+compare_output ("run", \@output, [<<'EOF']);
+(sema-bench) begin
+(sema-bench) 256 waiters: C cycles/sema_up
+(sema-bench) PASS
+(sema-bench) end
+EOF
+pass;
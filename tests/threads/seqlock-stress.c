@@ -0,0 +1,82 @@
+/* A writer thread repeatedly updates a pair of values under a
+   seqlock while the main thread reads them, yielding to the writer
+   halfway through every other read.  Every read that the seqlock
+   accepts must see a consistent pair, and the interrupted reads
+   must be retried.  Also checks that timer_ticks(), which reads
+   the tick count under a seqlock, never goes backward. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WRITES 1000
+
+static struct seqlock seqlock;
+static int64_t a, b;
+static volatile bool writer_done;
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  int64_t i;
+
+  for (i = 1; i <= WRITES; i++)
+    {
+      enum intr_level old_level = intr_disable ();
+      seqlock_write_begin (&seqlock);
+      a = i;
+      barrier ();
+      b = -i;
+      seqlock_write_end (&seqlock);
+      intr_set_level (old_level);
+      thread_yield ();
+    }
+  writer_done = true;
+}
+
+void
+test_seqlock_stress (void) 
+{
+  int reads = 0, retries = 0;
+  int64_t start, last, now;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  seqlock_init (&seqlock);
+  thread_create ("writer", PRI_DEFAULT, writer_thread, NULL);
+
+  for (i = 0; !writer_done; i++)
+    {
+      unsigned seq = seqlock_read_begin (&seqlock);
+      int64_t x = a, y;
+
+      if (i % 2)
+        thread_yield ();
+      y = b;
+      if (seqlock_read_retry (&seqlock, seq))
+        retries++;
+      else
+        {
+          if (x != -y)
+            fail ("read inconsistent pair %lld, %lld", x, y);
+          reads++;
+        }
+    }
+  if (reads == 0 || retries == 0)
+    fail ("%d reads, %d retries", reads, retries);
+
+  start = last = timer_ticks ();
+  while ((now = timer_ticks ()) < start + 3)
+    {
+      if (now < last)
+        fail ("timer_ticks() went from %lld to %lld", last, now);
+      last = now;
+    }
+  pass ();
+}
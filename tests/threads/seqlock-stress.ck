@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(seqlock-stress) begin
+(seqlock-stress) PASS
+(seqlock-stress) end
+EOF
+pass;
@@ -0,0 +1,53 @@
+/* Measures console throughput inside the kernel.  Pushes a block
+   of text through putbuf() and reports how fast it was queued and
+   how fast the serial port drained it.  With interrupts on, every
+   byte must go out through the interrupt handler, so the test
+   fails if any were polled out instead.  tests/userprog/
+   console-throughput measures the same thing through
+   write(1, ...). */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "devices/serial.h"
+#include "devices/timer.h"
+
+#define LINE_LEN 64
+#define LINE_CNT 256
+
+void
+test_serial_throughput (void) 
+{
+  char *buf = malloc (LINE_LEN * LINE_CNT);
+  int64_t start, queued, drained;
+  long long polled;
+  size_t i;
+
+  ASSERT (buf != NULL);
+  for (i = 0; i < LINE_LEN * LINE_CNT; i++)
+    buf[i] = i % LINE_LEN == LINE_LEN - 1 ? '\n' : '.';
+
+  /* Start from an empty transmit queue. */
+  while (serial_queued () > 0)
+    timer_sleep (1);
+
+  polled = serial_polled ();
+  start = timer_ticks ();
+  putbuf (buf, LINE_LEN * LINE_CNT);
+  queued = timer_elapsed (start);
+  while (serial_queued () > 0)
+    timer_sleep (1);
+  drained = timer_elapsed (start);
+  polled = serial_polled () - polled;
+  free (buf);
+
+  msg ("%d bytes queued in %lld ticks, drained in %lld ticks",
+       LINE_LEN * LINE_CNT, queued, drained);
+  if (drained > 0)
+    msg ("%lld bytes per second",
+         (int64_t) LINE_LEN * LINE_CNT * TIMER_FREQ / drained);
+  if (polled != 0)
+    fail ("%lld bytes were polled out instead of queued", polled);
+  pass ();
+}
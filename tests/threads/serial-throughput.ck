@@ -0,0 +1,25 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The timing varies from run to run.
+s/queued in \d+ ticks, drained in \d+ ticks$/queued in T ticks, drained in T ticks/
+  foreach @output;
+s/^\(serial-throughput\) \d+ bytes per second$/(serial-throughput) R bytes per second/
+  foreach @output;
+
+# The rate is left out when the queue drained within a tick.
+my (@head) = ("(serial-throughput) begin", ('.' x 63) x 256,
+	      "(serial-throughput) 16384 bytes queued in T ticks, "
+	      . "drained in T ticks");
+my (@tail) = ("(serial-throughput) PASS", "(serial-throughput) end");
+compare_output ("run", \@output,
+		[join ("\n", @head, "(serial-throughput) R bytes per second",
+		       @tail),
+		 join ("\n", @head, @tail)]);
+pass;
@@ -0,0 +1,166 @@
+/* Measures the block memory routines in lib/string.c and the
+   page routines in palloc.c against a plain byte-at-a-time loop,
+   and reports the throughput of each in GB/s. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define BUF_PAGES 16
+#define BUF_SIZE (BUF_PAGES * PGSIZE)
+#define BENCH_TICKS 20
+
+static char *src, *dst;
+
+/* Expected result of the memmove checks, built a byte at a time. */
+#define CHECK_SIZE 4096
+static char expected[CHECK_SIZE];
+
+/* Reference: what every routine did before. */
+static void
+byte_copy (void)
+{
+  char *d = dst;
+  const char *s = src;
+  size_t n = BUF_SIZE;
+
+  while (n-- > 0)
+    *d++ = *s++;
+}
+
+static void
+do_memcpy (void)
+{
+  memcpy (dst, src, BUF_SIZE);
+}
+
+static void
+do_memmove (void)
+{
+  memmove (dst + 1, dst, BUF_SIZE - 1);
+}
+
+static void
+do_memset (void)
+{
+  memset (dst, 0x5a, BUF_SIZE);
+}
+
+static void
+do_memcmp (void)
+{
+  if (memcmp (dst, src, BUF_SIZE) != 0)
+    fail ("memcmp found a difference in equal blocks");
+}
+
+static void
+do_strlen (void)
+{
+  if (strlen (src) != BUF_SIZE - 1)
+    fail ("strlen returned the wrong length");
+}
+
+static void
+do_copy_page (void)
+{
+  size_t i;
+
+  for (i = 0; i < BUF_PAGES; i++)
+    copy_page (dst + i * PGSIZE, src + i * PGSIZE);
+}
+
+static void
+do_clear_page (void)
+{
+  size_t i;
+
+  for (i = 0; i < BUF_PAGES; i++)
+    clear_page (dst + i * PGSIZE);
+}
+
+/* Runs FUNC over BUF_SIZE bytes until BENCH_TICKS timer ticks
+   have passed and reports the rate. */
+static void
+bench (const char *name, void (*func) (void))
+{
+  int64_t start, elapsed;
+  int64_t bytes = 0;
+  int64_t mbps;
+
+  /* Start on a tick boundary. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+
+  start = timer_ticks ();
+  do
+    {
+      func ();
+      bytes += BUF_SIZE;
+      elapsed = timer_elapsed (start);
+    }
+  while (elapsed < BENCH_TICKS);
+
+  mbps = bytes * TIMER_FREQ / elapsed / 1000000;
+  msg ("%-10s %lld.%02lld GB/s", name, mbps / 1000, mbps % 1000 / 10);
+}
+
+/* Moves SIZE bytes from offset FROM to offset TO in a buffer
+   holding a position-dependent pattern, and checks the result
+   against the same move done a byte at a time in the right
+   direction. */
+static void
+check_memmove (size_t to, size_t from, size_t size)
+{
+  size_t i;
+
+  ASSERT (to + size <= CHECK_SIZE && from + size <= CHECK_SIZE);
+
+  for (i = 0; i < CHECK_SIZE; i++)
+    dst[i] = expected[i] = i * 7;
+  if (to < from)
+    for (i = 0; i < size; i++)
+      expected[to + i] = expected[from + i];
+  else
+    for (i = size; i-- > 0; )
+      expected[to + i] = expected[from + i];
+
+  memmove (dst + to, dst + from, size);
+  for (i = 0; i < CHECK_SIZE; i++)
+    if (dst[i] != expected[i])
+      fail ("memmove (%zu, %zu, %zu) left byte %zu as %d, not %d",
+            to, from, size, i, dst[i], expected[i]);
+}
+
+void
+test_string_bench (void) 
+{
+  src = palloc_get_multiple (PAL_ASSERT, BUF_PAGES);
+  dst = palloc_get_multiple (PAL_ASSERT, BUF_PAGES);
+  memset (src, 'x', BUF_SIZE - 1);
+  src[BUF_SIZE - 1] = '\0';
+
+  bench ("byte loop", byte_copy);
+  bench ("memcpy", do_memcpy);
+  bench ("memmove", do_memmove);
+  bench ("memset", do_memset);
+  do_memcpy ();
+  bench ("memcmp", do_memcmp);
+  bench ("strlen", do_strlen);
+  bench ("copy_page", do_copy_page);
+  bench ("clear_page", do_clear_page);
+
+  /* Check the overlapping cases of memmove both ways.  Neighboring
+     bytes differ, so a copy in the wrong direction shows up. */
+  check_memmove (3, 0, 1000);
+  check_memmove (3, 0, 20);
+  check_memmove (200, 205, 1000);
+  check_memmove (200, 205, 20);
+
+  palloc_free_multiple (src, BUF_PAGES);
+  palloc_free_multiple (dst, BUF_PAGES);
+  pass ();
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The rates vary from run to run.
+s/ \d+\.\d\d GB\/s$/ R GB\/s/ foreach @output;
+
+my ($expected) = join ("\n",
+		       "(string-bench) begin",
+		       map (sprintf ("(string-bench) %-10s R GB/s", $_),
+			    "byte loop", "memcpy", "memmove", "memset",
+			    "memcmp", "strlen", "copy_page", "clear_page"),
+		       "(string-bench) PASS",
+		       "(string-bench) end");
+compare_output ("run", \@output, [$expected]);
+pass;
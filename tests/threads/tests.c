@@ -29,6 +29,17 @@ static const struct test tests[] =
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"serial-throughput", test_serial_throughput},
+    {"string-bench", test_string_bench},
+    {"thread-spawn-bench", test_thread_spawn_bench},
+    {"hash-bench", test_hash_bench},
+    {"tlb-bench", test_tlb_bench},
+    {"sema-bench", test_sema_bench},
+    {"lock-stats", test_lock_stats},
+    {"rwlock-donate", test_rwlock_donate},
+    {"rwlock-stress", test_rwlock_stress},
+    {"seqlock-stress", test_seqlock_stress},
+    {"intr-off-bound", test_intr_off_bound},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
@@ -23,6 +23,17 @@ extern test_func test_priority_fifo;
 extern test_func test_priority_preempt;
 extern test_func test_priority_sema;
 extern test_func test_priority_condvar;
+extern test_func test_serial_throughput;
+extern test_func test_string_bench;
+extern test_func test_thread_spawn_bench;
+extern test_func test_hash_bench;
+extern test_func test_tlb_bench;
+extern test_func test_sema_bench;
+extern test_func test_lock_stats;
+extern test_func test_rwlock_donate;
+extern test_func test_rwlock_stress;
+extern test_func test_seqlock_stress;
+extern test_func test_intr_off_bound;
 extern test_func test_mlfqs_load_1;
 extern test_func test_mlfqs_load_60;
 extern test_func test_mlfqs_load_avg;
@@ -0,0 +1,65 @@
+/* Measures thread creation.  Repeatedly creates a thread that
+   exits right away and waits for it, as a worker pool does under
+   churn, and reports creates per second along with the latency of
+   thread_create() itself at several percentiles. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+#define SPAWN_CNT 2000
+
+static void
+worker (void *done_)
+{
+  struct semaphore *done = done_;
+  sema_up (done);
+}
+
+static int
+compare_u64 (const void *a_, const void *b_)
+{
+  const uint64_t *a = a_;
+  const uint64_t *b = b_;
+  return *a < *b ? -1 : *a > *b;
+}
+
+void
+test_thread_spawn_bench (void) 
+{
+  uint64_t *cycles = malloc (SPAWN_CNT * sizeof *cycles);
+  struct semaphore done;
+  int64_t start, elapsed;
+  int i;
+
+  ASSERT (cycles != NULL);
+  sema_init (&done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < SPAWN_CNT; i++)
+    {
+      uint64_t t0 = rdtsc ();
+      tid_t tid = thread_create ("worker", PRI_DEFAULT, worker, &done);
+      cycles[i] = rdtsc () - t0;
+      if (tid == TID_ERROR)
+        fail ("thread_create failed at iteration %d", i);
+      sema_down (&done);
+    }
+  elapsed = timer_elapsed (start);
+
+  qsort (cycles, SPAWN_CNT, sizeof *cycles, compare_u64);
+  msg ("%d threads in %lld ticks", SPAWN_CNT, elapsed);
+  if (elapsed > 0)
+    msg ("%lld creates per second",
+         (int64_t) SPAWN_CNT * TIMER_FREQ / elapsed);
+  msg ("thread_create cycles: p50 %llu, p90 %llu, p99 %llu, max %llu",
+       cycles[SPAWN_CNT / 2], cycles[SPAWN_CNT * 9 / 10],
+       cycles[SPAWN_CNT * 99 / 100], cycles[SPAWN_CNT - 1]);
+  free (cycles);
+  pass ();
+}
@@ -0,0 +1,31 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The timing varies from run to run.
+s/ in \d+ ticks$/ in T ticks/ foreach @output;
+s/^\(thread-spawn-bench\) \d+ creates per second$/(thread-spawn-bench) R creates per second/
+  foreach @output;
+s/p50 \d+, p90 \d+, p99 \d+, max \d+$/p50 C, p90 C, p99 C, max C/ foreach @output;
+
+# The rate is left out when the run took less than a tick.
+compare_output ("run", \@output, [<<'EOF', <<'EOF']);
+(thread-spawn-bench) begin
+(thread-spawn-bench) 2000 threads in T ticks
+(thread-spawn-bench) R creates per second
+(thread-spawn-bench) thread_create cycles: p50 C, p90 C, p99 C, max C
+(thread-spawn-bench) PASS
+(thread-spawn-bench) end
+EOF
+(thread-spawn-bench) begin
+(thread-spawn-bench) 2000 threads in T ticks
+(thread-spawn-bench) thread_create cycles: p50 C, p90 C, p99 C, max C
+(thread-spawn-bench) PASS
+(thread-spawn-bench) end
+EOF
+pass;
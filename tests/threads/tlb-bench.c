@@ -0,0 +1,48 @@
+/* Measures TLB reach in the kernel's mapping of physical memory.
+   Touches one byte in every page of a 16 MB buffer, more pages
+   than the TLB can hold with 4 kB entries, and reports the average
+   cycles per access for a sequential and a scattered walk.  Run
+   it once normally, where the kernel maps memory with 2 MB pages,
+   and once with -no-huge to compare against 4 kB pages. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+#define BUF_PAGES 4096
+#define ROUNDS 16
+
+/* Touches the first byte of every page of BUF, in the order given
+   by stepping through the pages STRIDE at a time, ROUNDS times.
+   Returns the average cycles per access. */
+static uint64_t
+walk (volatile uint8_t *buf, size_t stride)
+{
+  uint64_t start = rdtsc ();
+  size_t round, i, page;
+
+  for (round = 0; round < ROUNDS; round++)
+    for (i = 0, page = 0; i < BUF_PAGES; i++, page = (page + stride) % BUF_PAGES)
+      buf[page * PGSIZE]++;
+  return (rdtsc () - start) / (ROUNDS * BUF_PAGES);
+}
+
+void
+test_tlb_bench (void) 
+{
+  uint8_t *buf = palloc_get_multiple (0, BUF_PAGES);
+
+  if (buf == NULL)
+    fail ("could not allocate %d pages", BUF_PAGES);
+
+  /* The first walk just warms the caches. */
+  walk (buf, 1);
+  msg ("sequential: %llu cycles/access", walk (buf, 1));
+  /* An odd stride visits every page, never two in a row nearby. */
+  msg ("scattered:  %llu cycles/access", walk (buf, 1031));
+
+  palloc_free_multiple (buf, BUF_PAGES);
+  pass ();
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle counts vary from run to run.
+s/ \d+ cycles\/access$/ C cycles\/access/ foreach @output;
+
+compare_output ("run", \@output, [<<'EOF']);
+(tlb-bench) begin
+(tlb-bench) sequential: C cycles/access
+(tlb-bench) scattered:  C cycles/access
+(tlb-bench) PASS
+(tlb-bench) end
+EOF
+pass;
@@ -0,0 +1,19 @@
+/* Child process run by exec-bench and spawn-bench.
+   Carries 256 kB of initialized data, so that loading it reads
+   many pages from the file system. */
+
+#include <stdio.h>
+#include "tests/lib.h"
+
+#define BIG_SIZE (256 * 1024)
+
+static char big[BIG_SIZE] = {1};
+
+const char *test_name = "child-big";
+int
+main (void) 
+{
+  if (big[0] != 1 || big[BIG_SIZE - 1] != 0)
+    fail ("data segment not loaded correctly");
+  return 82;
+}
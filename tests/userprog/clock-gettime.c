@@ -0,0 +1,40 @@
+/* Reads the monotonic clock repeatedly and checks that it is
+   well formed, never goes backward, and moves. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define READS 1000
+
+static long long
+to_ns (const struct timespec *ts)
+{
+  return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+void
+test_main (void) 
+{
+  struct timespec first, prev, now;
+  int i;
+
+  CHECK (clock_gettime (CLOCK_MONOTONIC, &first) == 0,
+         "clock_gettime (CLOCK_MONOTONIC)");
+  prev = first;
+  for (i = 0; i < READS; i++)
+    {
+      if (clock_gettime (CLOCK_MONOTONIC, &now) != 0)
+        fail ("clock_gettime() failed on read %d", i);
+      if (now.tv_nsec < 0 || now.tv_nsec >= 1000000000)
+        fail ("tv_nsec is %ld", now.tv_nsec);
+      if (to_ns (&now) < to_ns (&prev))
+        fail ("clock went from %lld to %lld ns", to_ns (&prev), to_ns (&now));
+      prev = now;
+    }
+  if (to_ns (&now) == to_ns (&first))
+    fail ("clock did not move in %d reads", READS);
+
+  CHECK (clock_gettime (12345, &now) == -1,
+         "clock_gettime (12345) must fail");
+}
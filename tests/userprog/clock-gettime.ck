@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clock-gettime) begin
+(clock-gettime) clock_gettime (CLOCK_MONOTONIC)
+(clock-gettime) clock_gettime (12345) must fail
+(clock-gettime) end
+clock-gettime: exit(0)
+EOF
+pass;
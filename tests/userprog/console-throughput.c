@@ -0,0 +1,43 @@
+/* Measures console throughput through write(1, ...): writes
+   16 kB of text to the console a line at a time and reports how
+   many bytes per second got through. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LINE_LEN 64
+#define LINE_CNT 256
+
+static char line[LINE_LEN];
+
+static long long
+to_ns (const struct timespec *ts)
+{
+  return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+void
+test_main (void) 
+{
+  struct timespec start, end;
+  long long ns;
+  int i;
+
+  for (i = 0; i < LINE_LEN - 1; i++)
+    line[i] = '.';
+  line[LINE_LEN - 1] = '\n';
+
+  if (clock_gettime (CLOCK_MONOTONIC, &start) != 0)
+    fail ("clock_gettime() failed");
+  for (i = 0; i < LINE_CNT; i++)
+    if (write (STDOUT_FILENO, line, LINE_LEN) != LINE_LEN)
+      fail ("write of line %d returned short", i);
+  if (clock_gettime (CLOCK_MONOTONIC, &end) != 0)
+    fail ("clock_gettime() failed");
+
+  ns = to_ns (&end) - to_ns (&start);
+  msg ("%d bytes in %lld us, %lld bytes per second", LINE_LEN * LINE_CNT,
+       ns / 1000, ns > 0 ? LINE_LEN * LINE_CNT * 1000000000LL / ns : 0);
+}
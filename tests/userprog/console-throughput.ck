@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The timing varies from run to run.
+s/\d+ us, \d+ bytes per second$/T us, R bytes per second/ foreach @output;
+
+my ($expected) = join ("\n",
+		       "(console-throughput) begin",
+		       ('.' x 63) x 256,
+		       "(console-throughput) 16384 bytes in T us, R bytes per second",
+		       "(console-throughput) end",
+		       "console-throughput: exit(0)");
+compare_output ("run", \@output, [$expected]);
+pass;
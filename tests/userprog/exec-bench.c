@@ -0,0 +1,37 @@
+/* Measures exec latency for a small and a large executable.
+   Forks and execs each one repeatedly; the kernel reports the time
+   spent loading, by image size, in its statistics at shutdown. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define EXEC_CNT 10
+
+static void
+run (const char *prog, int expected)
+{
+  int i;
+
+  for (i = 0; i < EXEC_CNT; i++)
+    {
+      pid_t pid = fork (prog);
+      if (pid == 0)
+        {
+          exec (prog);
+          fail ("exec \"%s\" failed", prog);
+        }
+      if (pid < 0)
+        fail ("fork failed");
+      if (wait (pid) != expected)
+        fail ("wrong exit code from \"%s\"", prog);
+    }
+  msg ("exec'd \"%s\" %d times", prog, EXEC_CNT);
+}
+
+void
+test_main (void) 
+{
+  run ("child-simple", 81);
+  run ("child-big", 82);
+}
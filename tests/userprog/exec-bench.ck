@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+my ($expected) = "(exec-bench) begin\n"
+  . ("(child-simple) run\nchild-simple: exit(81)\n" x 10)
+  . "(exec-bench) exec'd \"child-simple\" 10 times\n"
+  . ("child-big: exit(82)\n" x 10)
+  . "(exec-bench) exec'd \"child-big\" 10 times\n"
+  . "(exec-bench) end\n"
+  . "exec-bench: exit(0)\n";
+check_expected ([$expected]);
+pass;
@@ -0,0 +1,180 @@
+/* Compares small writes and reads done one system call at a time
+   with the same requests batched through an I/O ring, checks that
+   both see the same data, and runs the other ring operations. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERS IO_RING_SIZE
+#define BLOCK 64
+#define FILE_SIZE (ITERS * BLOCK)
+
+static char buf[FILE_SIZE];
+static char expected[FILE_SIZE];
+static struct io_ring ring;
+
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Checks that the next CNT completions are in order, starting
+   from user_data FIRST, and returned RES, and consumes them. */
+static void
+check_completions (int first, int cnt, int res)
+{
+  struct io_cqe *cqe;
+  int i;
+
+  for (i = first; i < first + cnt; i++)
+    {
+      if ((cqe = io_ring_peek (&ring)) == NULL)
+        fail ("missing completion %d", i);
+      if (cqe->user_data != (uint64_t) i || cqe->res != res)
+        fail ("completion %d: user_data %llu, res %d",
+              i, cqe->user_data, cqe->res);
+      io_ring_advance (&ring);
+    }
+}
+
+/* Consumes the next CNT completions, checking that they are in
+   order, and prints each one's result labeled with NAMES[]. */
+static void
+print_completions (const char *names[], int cnt)
+{
+  struct io_cqe *cqe;
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      if ((cqe = io_ring_peek (&ring)) == NULL)
+        fail ("missing completion %d", i);
+      if (cqe->user_data != (uint64_t) i)
+        fail ("completion %d has user_data %llu", i, cqe->user_data);
+      msg ("%s: %d", names[i], cqe->res);
+      io_ring_advance (&ring);
+    }
+}
+
+/* Writes or reads the file in BLOCK-byte pieces with one ring
+   batch, returning the cycles taken. */
+static uint64_t
+ring_io (int handle, bool writing)
+{
+  uint64_t start;
+  int i;
+
+  for (i = 0; i < ITERS; i++)
+    io_ring_queue (&ring, writing ? IO_OP_WRITE : IO_OP_READ, handle,
+                   buf + i * BLOCK, BLOCK, i);
+  seek (handle, 0);
+  start = rdtsc ();
+  if (io_ring_enter (&ring) != ITERS)
+    fail ("io_ring_enter() did not run every request");
+  start = rdtsc () - start;
+  check_completions (0, ITERS, BLOCK);
+  return start;
+}
+
+static const char *file_ops[] =
+  {"seek", "read", "fsync", "close", "read after close"};
+static const char *bad_ops[] =
+  {"write to console", "open bad name", "nop"};
+
+void
+test_main (void) 
+{
+  uint64_t start, plain_cycles, ring_cycles;
+  struct io_cqe *cqe;
+  int handle, i;
+
+  for (i = 0; i < FILE_SIZE; i++)
+    expected[i] = i * 7;
+  CHECK (create ("bench.dat", FILE_SIZE), "create \"bench.dat\"");
+  CHECK ((handle = open ("bench.dat")) > 1, "open \"bench.dat\"");
+  io_ring_init (&ring);
+
+  /* One system call per block. */
+  memcpy (buf, expected, FILE_SIZE);
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    if (write (handle, buf + i * BLOCK, BLOCK) != BLOCK)
+      fail ("write failed");
+  plain_cycles = rdtsc () - start;
+  msg ("plain write: %llu cycles per block", plain_cycles / ITERS);
+
+  memset (buf, 0, FILE_SIZE);
+  seek (handle, 0);
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    if (read (handle, buf + i * BLOCK, BLOCK) != BLOCK)
+      fail ("read failed");
+  plain_cycles = rdtsc () - start;
+  msg ("plain read: %llu cycles per block", plain_cycles / ITERS);
+  if (memcmp (buf, expected, FILE_SIZE))
+    fail ("plain read returned the wrong data");
+
+  /* The same blocks, one batch each way. */
+  for (i = 0; i < FILE_SIZE; i++)
+    expected[i] = i * 13;
+  memcpy (buf, expected, FILE_SIZE);
+  ring_cycles = ring_io (handle, true);
+  msg ("ring write: %d completions, %llu cycles per block",
+       ITERS, ring_cycles / ITERS);
+
+  memset (buf, 0, FILE_SIZE);
+  ring_cycles = ring_io (handle, false);
+  msg ("ring read: %d completions, %llu cycles per block",
+       ITERS, ring_cycles / ITERS);
+  if (memcmp (buf, expected, FILE_SIZE))
+    fail ("ring read returned the wrong data");
+
+  /* What the ring wrote, plain read() sees. */
+  memset (buf, 0, FILE_SIZE);
+  seek (handle, 0);
+  if (read (handle, buf, FILE_SIZE) != FILE_SIZE
+      || memcmp (buf, expected, FILE_SIZE))
+    fail ("plain read did not see the ring's writes");
+  close (handle);
+
+  /* Open, seek, read, fsync and close in one batch.  The fd that
+     the open returns is only known afterward, so the rest goes in
+     a second batch. */
+  io_ring_queue (&ring, IO_OP_OPEN, 0, "bench.dat", 0, 0);
+  if (io_ring_enter (&ring) != 1 || (cqe = io_ring_peek (&ring)) == NULL)
+    fail ("ring open did not complete");
+  handle = cqe->res;
+  if (handle < 2)
+    fail ("ring open returned %d", handle);
+  io_ring_advance (&ring);
+  msg ("ring open \"bench.dat\"");
+
+  memset (buf, 0, BLOCK);
+  io_ring_queue (&ring, IO_OP_SEEK, handle, NULL, BLOCK * 3, 0);
+  io_ring_queue (&ring, IO_OP_READ, handle, buf, BLOCK, 1);
+  io_ring_queue (&ring, IO_OP_FSYNC, handle, NULL, 0, 2);
+  io_ring_queue (&ring, IO_OP_CLOSE, handle, NULL, 0, 3);
+  io_ring_queue (&ring, IO_OP_READ, handle, buf, BLOCK, 4);
+  if (io_ring_enter (&ring) != 5)
+    fail ("io_ring_enter() did not run every request");
+  print_completions (file_ops, 5);
+  if (memcmp (buf, expected + BLOCK * 3, BLOCK))
+    fail ("read after ring seek returned the wrong data");
+
+  /* The console is not a file, and a bad buffer fails only its
+     own request. */
+  io_ring_queue (&ring, IO_OP_WRITE, 1, buf, BLOCK, 0);
+  io_ring_queue (&ring, IO_OP_OPEN, 0, (void *) 0x20101234, 0, 1);
+  io_ring_queue (&ring, IO_OP_NOP, 0, NULL, 0, 2);
+  if (io_ring_enter (&ring) != 3)
+    fail ("io_ring_enter() did not run every request");
+  print_completions (bad_ops, 3);
+  if (io_ring_peek (&ring) != NULL)
+    fail ("extra completion");
+}
@@ -0,0 +1,33 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle counts vary from run to run.
+s/\d+ cycles per block$/C cycles per block/ foreach @output;
+
+compare_output ("run", \@output, [<<'EOF']);
+(io-ring-bench) begin
+(io-ring-bench) create "bench.dat"
+(io-ring-bench) open "bench.dat"
+(io-ring-bench) plain write: C cycles per block
+(io-ring-bench) plain read: C cycles per block
+(io-ring-bench) ring write: 64 completions, C cycles per block
+(io-ring-bench) ring read: 64 completions, C cycles per block
+(io-ring-bench) ring open "bench.dat"
+(io-ring-bench) seek: 0
+(io-ring-bench) read: 64
+(io-ring-bench) fsync: 0
+(io-ring-bench) close: 0
+(io-ring-bench) read after close: -1
+(io-ring-bench) write to console: -1
+(io-ring-bench) open bad name: -1
+(io-ring-bench) nop: 0
+(io-ring-bench) end
+io-ring-bench: exit(0)
+EOF
+pass;
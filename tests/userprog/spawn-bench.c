@@ -0,0 +1,79 @@
+/* Compares the cost of starting a child with fork() and exec()
+   against spawn(), for a small and a large executable.  fork()
+   copies the whole address space only for exec() to discard it;
+   spawn() loads the executable into an empty one. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define RUN_CNT 10
+
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Runs PROG RUN_CNT times with fork() and exec(), returning the
+   average cycles per child. */
+static uint64_t
+run_fork (const char *prog, int expected)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < RUN_CNT; i++)
+    {
+      pid_t pid = fork (prog);
+      if (pid == 0)
+        {
+          exec (prog);
+          fail ("exec \"%s\" failed", prog);
+        }
+      if (pid < 0)
+        fail ("fork failed");
+      if (wait (pid) != expected)
+        fail ("wrong exit code from \"%s\"", prog);
+    }
+  return (rdtsc () - start) / RUN_CNT;
+}
+
+/* Runs PROG RUN_CNT times with spawn(), returning the average
+   cycles per child. */
+static uint64_t
+run_spawn (const char *prog, int expected)
+{
+  uint64_t start = rdtsc ();
+  int i;
+
+  for (i = 0; i < RUN_CNT; i++)
+    {
+      pid_t pid = spawn (prog, NULL, 0);
+      if (pid < 0)
+        fail ("spawn \"%s\" failed", prog);
+      if (wait (pid) != expected)
+        fail ("wrong exit code from \"%s\"", prog);
+    }
+  return (rdtsc () - start) / RUN_CNT;
+}
+
+static void
+compare (const char *prog, int expected)
+{
+  uint64_t fork_cycles = run_fork (prog, expected);
+  uint64_t spawn_cycles = run_spawn (prog, expected);
+
+  msg ("%s: fork+exec+wait %llu cycles, spawn+wait %llu cycles",
+       prog, fork_cycles, spawn_cycles);
+}
+
+void
+test_main (void) 
+{
+  compare ("child-simple", 81);
+  compare ("child-big", 82);
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle counts vary from run to run.
+s/\d+ cycles, spawn\+wait \d+ cycles$/C cycles, spawn+wait C cycles/
+  foreach @output;
+
+my ($expected) = "(spawn-bench) begin\n"
+  . ("(child-simple) run\nchild-simple: exit(81)\n" x 20)
+  . "(spawn-bench) child-simple: fork+exec+wait C cycles, spawn+wait C cycles\n"
+  . ("child-big: exit(82)\n" x 20)
+  . "(spawn-bench) child-big: fork+exec+wait C cycles, spawn+wait C cycles\n"
+  . "(spawn-bench) end\n"
+  . "spawn-bench: exit(0)\n";
+compare_output ("run", \@output, [$expected]);
+pass;
@@ -0,0 +1,27 @@
+/* Opens a file and spawns a subprocess, handing it the file as a
+   different fd number.  The child closes its fd after checking the
+   contents; the parent's handle must still work afterward. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_FD 9
+
+void
+test_main (void) 
+{
+  struct spawn_fd action;
+  char child_cmd[128];
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  action.child_fd = CHILD_FD;
+  action.parent_fd = handle;
+  snprintf (child_cmd, sizeof child_cmd, "child-close %d", CHILD_FD);
+
+  msg ("wait(spawn()) = %d", wait (spawn (child_cmd, &action, 1)));
+  check_file_handle (handle, "sample.txt", sample, sizeof sample - 1);
+}
@@ -0,0 +1,97 @@
+/* Measures system call round trips from user space: a null call,
+   1-byte and 4 kB reads and writes, and open/close.  Then checks
+   that the kernel's own per-process statistics counted them. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ITERS 64
+#define BLOCK 4096
+#define FILE_SIZE (ITERS * BLOCK)
+
+static char buf[BLOCK];
+static struct syscall_stat stats[SYS_CNT];
+
+static inline uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Reads or writes SIZE bytes ITERS times from the start of
+   HANDLE, returning the average cycles per call. */
+static uint64_t
+run_io (int handle, bool writing, unsigned size)
+{
+  uint64_t start;
+  int i;
+
+  seek (handle, 0);
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    {
+      int n = writing ? write (handle, buf, size) : read (handle, buf, size);
+      if (n != (int) size)
+        fail ("%s of %u bytes returned %d",
+              writing ? "write" : "read", size, n);
+    }
+  return (rdtsc () - start) / ITERS;
+}
+
+void
+test_main (void) 
+{
+  uint64_t start, null_cycles, open_cycles;
+  int handle, i;
+
+  CHECK (create ("bench.dat", FILE_SIZE), "create \"bench.dat\"");
+  CHECK ((handle = open ("bench.dat")) > 1, "open \"bench.dat\"");
+
+  /* syscall_stats() with no room to copy into does no work. */
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    syscall_stats (SYSCALL_STATS_SELF, NULL, 0);
+  null_cycles = (rdtsc () - start) / ITERS;
+  msg ("null: %llu cycles", null_cycles);
+
+  msg ("write 1 byte: %llu cycles", run_io (handle, true, 1));
+  msg ("write 4 kB: %llu cycles", run_io (handle, true, BLOCK));
+  msg ("read 1 byte: %llu cycles", run_io (handle, false, 1));
+  msg ("read 4 kB: %llu cycles", run_io (handle, false, BLOCK));
+
+  start = rdtsc ();
+  for (i = 0; i < ITERS; i++)
+    {
+      int fd = open ("bench.dat");
+      if (fd < 2)
+        fail ("open \"bench.dat\" failed");
+      close (fd);
+    }
+  open_cycles = (rdtsc () - start) / ITERS;
+  msg ("open+close: %llu cycles", open_cycles);
+  close (handle);
+
+  /* The kernel saw every call above, with no errors. */
+  if (syscall_stats (SYSCALL_STATS_SELF, stats, SYS_CNT) != SYS_CNT)
+    fail ("syscall_stats() failed");
+  if (stats[SYS_SYSCALL_STATS].count < ITERS
+      || stats[SYS_WRITE].count < 2 * ITERS
+      || stats[SYS_READ].count < 2 * ITERS
+      || stats[SYS_OPEN].count < ITERS + 1
+      || stats[SYS_CLOSE].count < ITERS + 1)
+    fail ("kernel counted too few calls");
+  if (stats[SYS_READ].errors != 0 || stats[SYS_OPEN].errors != 0)
+    fail ("kernel counted errors that did not happen");
+  if (stats[SYS_READ].max_cycles == 0
+      || stats[SYS_READ].max_cycles * stats[SYS_READ].count
+         < stats[SYS_READ].cycles)
+    fail ("read statistics are inconsistent");
+  if (syscall_stats (SYSCALL_STATS_ALL, stats, SYS_CNT) != SYS_CNT
+      || stats[SYS_OPEN].count < ITERS + 1)
+    fail ("system-wide statistics missed our calls");
+}
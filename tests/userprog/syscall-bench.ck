@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+# The cycle counts vary from run to run.
+s/^(\(syscall-bench\) .*: )\d+ cycles$/$1C cycles/ foreach @output;
+
+compare_output ("run", \@output, [<<'EOF']);
+(syscall-bench) begin
+(syscall-bench) create "bench.dat"
+(syscall-bench) open "bench.dat"
+(syscall-bench) null: C cycles
+(syscall-bench) write 1 byte: C cycles
+(syscall-bench) write 4 kB: C cycles
+(syscall-bench) read 1 byte: C cycles
+(syscall-bench) read 4 kB: C cycles
+(syscall-bench) open+close: C cycles
+(syscall-bench) end
+syscall-bench: exit(0)
+EOF
+pass;
@@ -0,0 +1,73 @@
+/* Dumps the kernel event trace into a file and checks that the
+   dump is well formed and includes the trace_dump() call that
+   wrote it. */
+
+#include <string.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+#include <trace-event.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define DUMP_SIZE (sizeof (struct trace_header) \
+		+ TRACE_EVENT_CNT * sizeof (struct trace_event))
+
+static struct trace_event events[64];
+
+void
+test_main (void) 
+{
+  struct trace_header h;
+  bool found = false;
+  uint64_t i;
+  int handle, size;
+
+  CHECK (create ("trace.dat", DUMP_SIZE), "create \"trace.dat\"");
+  CHECK ((handle = open ("trace.dat")) > 1, "open \"trace.dat\"");
+
+  size = trace_dump (handle);
+  if (size < (int) sizeof h)
+    fail ("trace_dump() returned %d", size);
+
+  seek (handle, 0);
+  if (read (handle, &h, sizeof h) != (int) sizeof h)
+    fail ("read of trace header failed");
+  if (memcmp (h.magic, TRACE_MAGIC, sizeof h.magic)
+      || h.version != TRACE_VERSION
+      || h.event_size != sizeof (struct trace_event))
+    fail ("bad trace header");
+  if (h.event_cnt == 0
+      || size != (int) (sizeof h + h.event_cnt * h.event_size))
+    fail ("trace_dump() returned %d for %lld events",
+          size, (long long) h.event_cnt);
+  if (h.tsc_end <= h.tsc_start || h.ticks_end < h.ticks_start)
+    fail ("trace times go backward");
+
+  /* The ring is full of boot and load events by now, but the
+     trace_dump() call's own entry event is recorded before the
+     kernel stops recording to write the dump. */
+  for (i = 0; i < h.event_cnt; i += sizeof events / sizeof *events)
+    {
+      size_t cnt = h.event_cnt - i;
+      size_t j;
+
+      if (cnt > sizeof events / sizeof *events)
+        cnt = sizeof events / sizeof *events;
+      if (read (handle, events, cnt * sizeof *events)
+          != (int) (cnt * sizeof *events))
+        fail ("read of trace events failed");
+      for (j = 0; j < cnt; j++)
+        {
+          if (events[j].type >= TRACE_TYPE_CNT)
+            fail ("event %lld has bad type %u",
+                  (long long) (i + j), events[j].type);
+          if (events[j].type == TRACE_SYSCALL_ENTER
+              && events[j].arg[0] == SYS_TRACE_DUMP
+              && events[j].arg[1] == (uint64_t) handle)
+            found = true;
+        }
+    }
+  if (!found)
+    fail ("trace_dump() call is not in the trace");
+  msg ("trace is well formed");
+}
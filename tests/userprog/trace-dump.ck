@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(trace-dump) begin
+(trace-dump) create "trace.dat"
+(trace-dump) open "trace.dat"
+(trace-dump) trace is well formed
+(trace-dump) end
+trace-dump: exit(0)
+EOF
+pass;
@@ -21,10 +21,12 @@
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
 #include "userprog/gdt.h"
+#include "userprog/image.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
 #endif
@@ -49,6 +51,18 @@ static bool format_filesys;
 /* -q: Power off after kernel tasks complete? */
 bool power_off_when_done;
 
+/* -no-huge: Map kernel memory with 4 kB pages only? */
+static bool no_huge_pages;
+
+/* -no-pcid: Flush the TLB on every address space switch? */
+static bool no_pcid;
+
+/* -no-trace: Don't record kernel events? */
+static bool no_trace;
+
+/* -no-lapic: Don't use the local APIC timer? */
+static bool no_lapic;
+
 bool thread_tests;
 
 static void bss_init (void);
@@ -134,20 +148,26 @@ main (void) {
 	/* Initialize interrupt handlers. */
 	intr_init ();
 	timer_init ();
+	if (!no_trace)
+		trace_init ();
 	kbd_init ();
 	input_init ();
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	image_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	/*
 		serial_init_queue: 외부 디바이스를 쓰기 위한 초기화
-		timer_calibrate: 타이머가 자동으로 작동되도록
+		timer_calibrate: TSC 주파수를 PIT로 보정 (짧은 sleep과 나노초 시계에 사용)
+		timer_use_lapic: 짧은 sleep을 LAPIC 타이머로 깨우도록 (-no-lapic이면 생략)
 	*/
 	thread_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	if (!no_lapic)
+		timer_use_lapic ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -207,6 +227,11 @@ bss_init (void) {
 /* Populates the page table with the kernel virtual mapping,
  * and then sets up the CPU to use the new page directory.
  * Points base_pml4 to the pml4 it creates. */
+/*
+	커널 영역은 2 MB 단위로 정렬된 곳은 large page 하나로 매핑함 (page table 없이 PDE가 바로 가리킴)
+	TLB 엔트리 하나가 4 kB 대신 2 MB를 덮으므로 TLB miss가 줄고, page table 메모리도 아낌
+	커널 코드가 있는 2 MB는 읽기 전용 권한을 4 kB 단위로 줘야 하므로 기존처럼 page table 사용
+*/
 static void
 paging_init (uint64_t mem_end) {
 	uint64_t *pml4, *pte;
@@ -216,19 +241,32 @@ paging_init (uint64_t mem_end) {
 	extern char start, _end_kernel_text;
 	// Maps physical address [0 ~ mem_end] to
 	// [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-	for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+	for (uint64_t pa = 0; pa < mem_end; ) {
 		uint64_t va = (uint64_t) ptov(pa);
 
+		if (!no_huge_pages && large_pg_ofs (pa) == 0
+				&& pa + LARGE_PGSIZE <= mem_end
+				&& (va + LARGE_PGSIZE <= (uint64_t) &start
+					|| va >= (uint64_t) &_end_kernel_text)) {
+			if (!pml4_set_large_page (pml4, va, pa, PTE_W))
+				PANIC ("out of memory mapping the kernel");
+			pa += LARGE_PGSIZE;
+			continue;
+		}
+
 		perm = PTE_P | PTE_W;
 		if ((uint64_t) &start <= va && va < (uint64_t) &_end_kernel_text)
 			perm &= ~PTE_W;
 
 		if ((pte = pml4e_walk (pml4, va, 1)) != NULL)
 			*pte = pa | perm;
+		pa += PGSIZE;
 	}
 
 	// reload cr3
 	pml4_activate(0);
+	if (!no_pcid)
+		pml4_enable_pcid ();
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -285,6 +323,28 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-no-huge"))
+			no_huge_pages = true;
+		else if (!strcmp (name, "-no-pcid"))
+			no_pcid = true;
+		else if (!strcmp (name, "-no-trace"))
+			no_trace = true;
+		else if (!strcmp (name, "-no-softirq"))
+			intr_no_softirq = true;
+		else if (!strcmp (name, "-no-lapic"))
+			no_lapic = true;
+		else if (!strcmp (name, "-intr-prof"))
+			intr_prof = true;
+		else if (!strcmp (name, "-intr-bound"))
+			intr_prof_bound = atoi (value);
+		else if (!strcmp (name, "-headless"))
+			console_set_vga (false);
+		else if (!strcmp (name, "-baud")) {
+			int bps = value != NULL ? atoi (value) : 0;
+			if (bps < 300 || bps > 115200)
+				PANIC ("invalid baud rate `%s'", value);
+			serial_set_bps (bps);
+		}
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -397,6 +457,15 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -no-huge           Map kernel memory with 4 kB pages only.\n"
+			"  -no-pcid           Don't tag TLB entries with process IDs.\n"
+			"  -no-trace          Don't record kernel events for trace_dump().\n"
+			"  -no-softirq        Finish interrupt work inside the handler.\n"
+			"  -no-lapic          Don't use the local APIC timer for short sleeps.\n"
+			"  -intr-prof         Report how long interrupts stay off.\n"
+			"  -intr-bound=US     Fail intr-off-bound past US microseconds off.\n"
+			"  -headless          Do not mirror console output to VGA.\n"
+			"  -baud=BPS          Set serial port speed to BPS (300-115200).\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -416,6 +485,7 @@ power_off (void) {
 	print_stats ();
 
 	printf ("Powering off...\n");
+	serial_flush ();
 	outw (0x604, 0x2000);               /* Poweroff command for qemu */
 	for (;;);
 }
@@ -424,13 +494,19 @@ power_off (void) {
 static void
 print_stats (void) {
 	timer_print_stats ();
+	intr_print_stats ();
 	thread_print_stats ();
+	lock_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
 	console_print_stats ();
+	serial_print_stats ();
 	kbd_print_stats ();
 #ifdef USERPROG
 	exception_print_stats ();
+	syscall_print_stats ();
+	process_print_stats ();
+	image_print_stats ();
 #endif
 }
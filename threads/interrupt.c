@@ -2,13 +2,16 @@
 #include <debug.h>
 #include <inttypes.h>
 #include <stdint.h>
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
+#include "devices/lapic.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
@@ -103,6 +106,62 @@ static const char *intr_names[INTR_CNT];
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Softirqs raised by external interrupt handlers, in the order
+   they were raised.  Softirqs run with interrupts on, so another
+   external interrupt may arrive while one runs; that interrupt
+   raises its softirqs but leaves running them (and yielding) to
+   the outermost handler. */
+static struct list softirq_list;
+static bool in_softirq;         /* Are we running softirqs? */
+bool intr_no_softirq;
+
+/* Statistics. */
+static uint64_t intr_off_max[INTR_CNT]; /* Longest handler, cycles. */
+static long long softirq_cnt;       /* Softirqs run. */
+static uint64_t softirq_max;        /* Longest softirq, cycles. */
+
+static void run_softirqs (void);
+
+/* Interrupts-off profiling, enabled by "-intr-prof".
+
+   Each switch from interrupts on to off starts a section,
+   recording the TSC and the call site, and the next switch back
+   on ends it.  An external interrupt that arrives with interrupts
+   on starts a section on behalf of its handler, which ends when
+   the handler returns.  Interrupts can also come back on through
+   iretq, e.g. when a new process starts, without passing through
+   intr_enable(); the section left open that way is dropped the
+   next time interrupts go off. */
+bool intr_prof;
+int intr_prof_bound = 1000000 / TIMER_FREQ;
+
+#define PROF_WORST_CNT 8        /* Worst sections to remember. */
+#define PROF_BUCKET_CNT 48      /* Histogram buckets, by log2 cycles. */
+
+/* Worst interrupts-off section seen for a call site. */
+struct off_section {
+	uint64_t cycles;            /* Duration. */
+	uintptr_t site;             /* Caller of intr_disable(), or... */
+	const char *name;           /* ...interrupt name, if not null. */
+};
+
+static uint64_t off_start;      /* Start of open section, or 0. */
+static uintptr_t off_site;
+static const char *off_name;
+static struct off_section off_worst[PROF_WORST_CNT];
+static long long off_buckets[PROF_BUCKET_CNT];
+
+static void off_begin (uintptr_t site, const char *name);
+static void off_end (void);
+static enum intr_level disable (uintptr_t site);
+
+/* Returns true if VEC is an external interrupt: one of the
+   PIC's 16 lines or the local APIC timer. */
+static inline bool
+is_external (uint8_t vec) {
+	return (vec >= 0x20 && vec < 0x30) || vec == LAPIC_TIMER_VEC;
+}
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -128,14 +187,22 @@ intr_get_level (void) {
    returns the previous interrupt status. */
 enum intr_level
 intr_set_level (enum intr_level level) {
-	return level == INTR_ON ? intr_enable () : intr_disable ();
+	if (level == INTR_ON)
+		return intr_enable ();
+	return disable ((uintptr_t) __builtin_return_address (0));
 }
 
 /* Enables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_enable (void) {
 	enum intr_level old_level = intr_get_level ();
-	ASSERT (!intr_context ());
+
+	/* Softirqs run with interrupts on, but an external
+	   interrupt handler must not turn them back on. */
+	ASSERT (!in_external_intr);
+
+	if (intr_prof && old_level == INTR_OFF)
+		off_end ();
 
 	/* Enable interrupts by setting the interrupt flag.
 
@@ -149,6 +216,13 @@ intr_enable (void) {
 /* Disables interrupts and returns the previous interrupt status. */
 enum intr_level
 intr_disable (void) {
+	return disable ((uintptr_t) __builtin_return_address (0));
+}
+
+/* Disables interrupts on behalf of the caller at SITE and
+   returns the previous interrupt status. */
+static enum intr_level
+disable (uintptr_t site) {
 	enum intr_level old_level = intr_get_level ();
 
 	/* Disable interrupts by clearing the interrupt flag.
@@ -156,6 +230,9 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (intr_prof && old_level == INTR_ON)
+		off_begin (site, NULL);
+
 	return old_level;
 }
 
@@ -166,6 +243,7 @@ intr_init (void) {
 
 	/* Initialize interrupt controller. */
 	pic_init ();
+	list_init (&softirq_list);
 
 	/* Initialize IDT. */
 	for (i = 0; i < INTR_CNT; i++) {
@@ -223,11 +301,12 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 
 /* Registers external interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The handler will
-   execute with interrupts disabled. */
+   execute with interrupts disabled.  VEC_NO is a PIC interrupt
+   or the local APIC timer. */
 void
 intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 		const char *name) {
-	ASSERT (vec_no >= 0x20 && vec_no <= 0x2f);
+	ASSERT (is_external (vec_no));
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
@@ -252,11 +331,12 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
-/* Returns true during processing of an external interrupt
-   and false at all other times. */
+/* Returns true during processing of an external interrupt,
+   including the softirqs it raised, and false at all other
+   times. */
 bool
 intr_context (void) {
-	return in_external_intr;
+	return in_external_intr || in_softirq;
 }
 
 /* During processing of an external interrupt, directs the
@@ -268,6 +348,202 @@ intr_yield_on_return (void) {
 	ASSERT (intr_context ());
 	yield_on_return = true;
 }
+
+/* Initializes SQ to call FUNC with AUX when raised. */
+void
+softirq_init (struct softirq *sq, softirq_func *func, void *aux) {
+	ASSERT (sq != NULL);
+	ASSERT (func != NULL);
+
+	sq->func = func;
+	sq->aux = aux;
+	sq->pending = false;
+}
+
+/* Arranges for SQ to run before the current external interrupt
+   returns.  Must be called from an external interrupt handler. */
+void
+softirq_raise (struct softirq *sq) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (in_external_intr);
+
+	if (intr_no_softirq)
+		sq->func (sq->aux);
+	else if (!sq->pending) {
+		sq->pending = true;
+		list_push_back (&softirq_list, &sq->elem);
+	}
+}
+
+/* Runs pending softirqs, with interrupts on, until none are
+   left.  Called with interrupts off and returns the same way. */
+static void
+run_softirqs (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!in_softirq);
+
+	in_softirq = true;
+	while (!list_empty (&softirq_list)) {
+		struct softirq *sq = list_entry (list_pop_front (&softirq_list),
+				struct softirq, elem);
+		uint64_t start;
+
+		sq->pending = false;
+		intr_enable ();
+		start = rdtsc ();
+		sq->func (sq->aux);
+		intr_disable ();
+
+		start = rdtsc () - start;
+		if (start > softirq_max)
+			softirq_max = start;
+		softirq_cnt++;
+	}
+	in_softirq = false;
+}
+
+/* Starts an interrupts-off section at SITE or, if NAME is
+   nonnull, in the handler for interrupt NAME. */
+static void
+off_begin (uintptr_t site, const char *name) {
+	off_start = rdtsc ();
+	off_site = site;
+	off_name = name;
+}
+
+/* Ends the open interrupts-off section, if any, and adds it to
+   the statistics. */
+static void
+off_end (void) {
+	struct off_section *s, *least;
+	uint64_t cycles;
+	int bucket;
+
+	if (off_start == 0)
+		return;
+	cycles = rdtsc () - off_start;
+	off_start = 0;
+
+	for (bucket = 0; bucket < PROF_BUCKET_CNT - 1
+			&& cycles >= (1ull << bucket); bucket++)
+		continue;
+	off_buckets[bucket]++;
+
+	/* Keep the worst section for each site, and the worst
+	   PROF_WORST_CNT sites. */
+	least = off_worst;
+	for (s = off_worst; s < off_worst + PROF_WORST_CNT; s++) {
+		if (s->cycles != 0 && s->site == off_site && s->name == off_name) {
+			least = s;
+			break;
+		}
+		if (s->cycles < least->cycles)
+			least = s;
+	}
+	if (cycles > least->cycles) {
+		least->cycles = cycles;
+		least->site = off_site;
+		least->name = off_name;
+	}
+}
+
+/* Returns the number of TSC cycles per microsecond, or 0 if the
+   TSC is not calibrated yet. */
+static uint64_t
+cycles_per_us (void) {
+	return timer_tsc_hz () / 1000000;
+}
+
+/* Converts CYCLES to microseconds, rounding up. */
+static int64_t
+cycles_to_us (uint64_t cycles) {
+	uint64_t rate = cycles_per_us ();
+	return rate != 0 ? (int64_t) DIV_ROUND_UP (cycles, rate) : 0;
+}
+
+/* Forgets the interrupts-off sections seen so far and starts
+   recording new ones. */
+void
+intr_prof_reset (void) {
+	enum intr_level old_level = intr_disable ();
+
+	memset (off_worst, 0, sizeof off_worst);
+	memset (off_buckets, 0, sizeof off_buckets);
+	off_start = 0;
+	intr_prof = true;
+
+	intr_set_level (old_level);
+}
+
+/* Returns the longest time, in microseconds, that interrupts
+   stayed off since profiling started. */
+int64_t
+intr_prof_longest (void) {
+	uint64_t longest = 0;
+	int i;
+
+	for (i = 0; i < PROF_WORST_CNT; i++)
+		if (off_worst[i].cycles > longest)
+			longest = off_worst[i].cycles;
+	return cycles_to_us (longest);
+}
+
+/* Prints the interrupts-off profile: a histogram of section
+   lengths and the worst call sites. */
+static void
+print_prof (void) {
+	struct off_section worst[PROF_WORST_CNT];
+	int i, j, lo, hi;
+
+	for (lo = 0; lo < PROF_BUCKET_CNT && off_buckets[lo] == 0; lo++)
+		continue;
+	for (hi = PROF_BUCKET_CNT - 1; hi > lo && off_buckets[hi] == 0; hi--)
+		continue;
+	if (lo == PROF_BUCKET_CNT)
+		return;
+
+	printf ("Interrupts-off sections (about %"PRIu64" cycles/us):\n",
+			cycles_per_us ());
+	for (i = lo; i <= hi; i++)
+		printf ("  %10llu - %-10llu cycles: %lld\n",
+				i > 0 ? 1ull << (i - 1) : 0, (1ull << i) - 1, off_buckets[i]);
+
+	/* Sort worst first. */
+	memcpy (worst, off_worst, sizeof worst);
+	for (i = 1; i < PROF_WORST_CNT; i++)
+		for (j = i; j > 0 && worst[j].cycles > worst[j - 1].cycles; j--) {
+			struct off_section tmp = worst[j];
+			worst[j] = worst[j - 1];
+			worst[j - 1] = tmp;
+		}
+
+	printf ("Longest (resolve addresses with \"backtrace kernel.o\"):\n");
+	for (i = 0; i < PROF_WORST_CNT && worst[i].cycles != 0; i++) {
+		printf ("  %"PRIu64" cycles, %"PRId64" us, ",
+				worst[i].cycles, cycles_to_us (worst[i].cycles));
+		if (worst[i].name != NULL)
+			printf ("in %s handler\n", worst[i].name);
+		else
+			printf ("at %#llx\n", (unsigned long long) worst[i].site);
+	}
+}
+
+/* Prints interrupt statistics: for each external interrupt, the
+   longest time its handler kept interrupts off, and the
+   interrupts-off profile if enabled. */
+void
+intr_print_stats (void) {
+	int vec;
+
+	printf ("Interrupts: %lld softirqs run, longest %"PRIu64" cycles\n",
+			softirq_cnt, softirq_max);
+	for (vec = 0; vec < INTR_CNT; vec++)
+		if (intr_off_max[vec] != 0)
+			printf ("  %-16s longest %"PRIu64" cycles with interrupts off\n",
+					intr_names[vec], intr_off_max[vec]);
+	if (intr_prof)
+		print_prof ();
+}
 
 /* 8259A Programmable Interrupt Controller. */
 
@@ -332,19 +608,25 @@ void
 intr_handler (struct intr_frame *frame) {
 	bool external;
 	intr_handler_func *handler;
+	uint64_t start = 0;
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = is_external (frame->vec_no);
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
-		ASSERT (!intr_context ());
+		ASSERT (!in_external_intr);
 
 		in_external_intr = true;
-		yield_on_return = false;
+		if (!in_softirq)
+			yield_on_return = false;
+		start = rdtsc ();
 	}
+	if (intr_prof && (frame->eflags & FLAG_IF)
+			&& intr_get_level () == INTR_OFF)
+		off_begin (frame->rip, intr_names[frame->vec_no]);
 
 	/* Invoke the interrupt's handler. */
 	handler = intr_handlers[frame->vec_no];
@@ -367,11 +649,28 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_context ());
 
 		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
-
-		if (yield_on_return)
-			thread_yield ();
+		if (frame->vec_no == LAPIC_TIMER_VEC)
+			lapic_eoi ();
+		else
+			pic_end_of_interrupt (frame->vec_no);
+
+		start = rdtsc () - start;
+		if (start > intr_off_max[frame->vec_no])
+			intr_off_max[frame->vec_no] = start;
+
+		/* An interrupt that arrived while softirqs were running
+		   returns to them; they yield once they are done. */
+		if (!in_softirq) {
+			run_softirqs ();
+			if (yield_on_return)
+				thread_yield ();
+		}
 	}
+
+	/* Interrupts come back on when we return. */
+	if (intr_prof && (frame->eflags & FLAG_IF)
+			&& intr_get_level () == INTR_OFF)
+		off_end ();
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -36,6 +36,7 @@
 
 /* Descriptor. */
 struct desc {
+	char name[16];              /* Lock name, e.g. "malloc 16". */
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
 	struct list free_list;      /* List of free blocks. */
@@ -72,10 +73,11 @@ malloc_init (void) {
 	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
 		struct desc *d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
+		snprintf (d->name, sizeof d->name, "malloc %zu", block_size);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
 		list_init (&d->free_list);
-		lock_init (&d->lock);
+		lock_init_named (&d->lock, d->name);
 	}
 }
 
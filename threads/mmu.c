@@ -6,8 +6,64 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "threads/interrupt.h"
 #include "intrinsic.h"
 
+/* Process-context identifiers (PCIDs).
+
+   With CR4.PCIDE set, the low 12 bits of CR3 tag every TLB entry
+   with the address space that created it, so loading CR3 with bit
+   63 set switches address spaces without flushing the TLB: each
+   process finds its own translations still cached when it runs
+   again.  PCID 0 belongs to base_pml4; each other pml4 gets one of
+   the remaining PCID_CNT - 1 from a pool when it is first
+   activated, stealing one from an idle pml4 when the pool is
+   empty.  A PCID that may still have stale entries cached, because
+   it was just reassigned or its page tables changed while it was
+   not active, is marked stale and flushed when next loaded. */
+#define PCID_CNT 64                     /* Size of the PCID pool. */
+#define CR3_PCID_MASK 0xfffULL          /* PCID bits in CR3. */
+#define CR3_NOFLUSH (1ULL << 63)        /* Keep TLB entries on load. */
+#define CR4_PCIDE (1ULL << 17)          /* Enable PCIDs. */
+#define CPUID_1_ECX_PCID (1 << 17)      /* PCIDs supported. */
+
+/* Where a pml4 keeps its PCID: the last PML4 entry, which would map
+ * the top 512 GB of virtual memory and so is never present.  With
+ * the present bit clear, the CPU ignores the rest of the entry. */
+#define PCID_SLOT (PGSIZE / sizeof (uint64_t) - 1)
+#define PCID_SHIFT 1
+
+static bool pcid_enabled;
+static uint64_t *pcid_owner[PCID_CNT];  /* pml4 using each PCID, or null. */
+static bool pcid_stale[PCID_CNT];       /* Must flush on next load? */
+static unsigned pcid_hand = 1;          /* Next PCID to reuse. */
+
+static void pcid_put (uint64_t *pml4);
+
+/* Replaces the 2 MB large page mapped by page directory entry
+ * PDE by a page table mapping the same memory with 512 4 kB pages
+ * and the same permissions.  Returns false if out of memory. */
+static bool
+split_large_page (uint64_t *pde) {
+	uint64_t *pt = palloc_get_page (0);
+	uint64_t pa = PTE_ADDR (*pde);
+	uint64_t flags = *pde & PTE_FLAGS & ~PTE_PS;
+
+	if (pt == NULL)
+		return false;
+	for (unsigned i = 0; i < PGSIZE / sizeof (uint64_t *); i++)
+		pt[i] = (pa + i * PGSIZE) | flags;
+	*pde = vtop (pt) | PTE_U | PTE_W | PTE_P;
+
+	/* The kernel's part of the page tables is shared by every
+	 * process, so flush the whole TLB, not just one entry.  With
+	 * PCIDs this only flushes the current one, but the new page
+	 * table maps exactly what the large page did, so entries
+	 * cached under other PCIDs remain correct. */
+	lcr3 (rcr3 ());
+	return true;
+}
+
 static uint64_t *
 pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 	int idx = PDX (va);
@@ -22,6 +78,11 @@ pgdir_walk (uint64_t *pdp, const uint64_t va, int create) {
 					return NULL;
 			} else
 				return NULL;
+		} else if ((uint64_t) pte & PTE_PS) {
+			if (!create)
+				return &pdp[idx];
+			if (!split_large_page (&pdp[idx]))
+				return NULL;
 		}
 		return (uint64_t *) ptov (PTE_ADDR (pdp[idx]) + 8 * PTX (va));
 	}
@@ -60,7 +121,11 @@ pdpe_walk (uint64_t *pdpe, const uint64_t va, int create) {
  * If PML4E does not have a page table for VADDR, behavior depends
  * on CREATE.  If CREATE is true, then a new page table is
  * created and a pointer into it is returned.  Otherwise, a null
- * pointer is returned. */
+ * pointer is returned.
+ * If VADDR lies in a 2 MB large page, then without CREATE the
+ * page directory entry of the large page is returned, with PTE_PS
+ * set; with CREATE, the large page is first split into 4 kB
+ * pages. */
 uint64_t *
 pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	uint64_t *pte = NULL;
@@ -88,6 +153,35 @@ pml4e_walk (uint64_t *pml4e, const uint64_t va, int create) {
 	return pte;
 }
 
+/* Maps the 2 MB of virtual memory at VA, which must be aligned
+ * to 2 MB, to the physical memory at PA, aligned likewise, as a
+ * single large page with permission FLAGS, creating page
+ * directories as needed.  Any existing mapping in that range must
+ * not use a page table.  Returns false if out of memory. */
+bool
+pml4_set_large_page (uint64_t *pml4, uint64_t va, uint64_t pa,
+		uint64_t flags) {
+	uint64_t *table = pml4;
+	unsigned idx[2] = {PML4 (va), PDPE (va)};
+
+	ASSERT (large_pg_ofs (va) == 0);
+	ASSERT (large_pg_ofs (pa) == 0);
+
+	for (int i = 0; i < 2; i++) {
+		if (!(table[idx[i]] & PTE_P)) {
+			uint64_t *new_page = palloc_get_page (PAL_ZERO);
+			if (new_page == NULL)
+				return false;
+			table[idx[i]] = vtop (new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov (PTE_ADDR (table[idx[i]]));
+	}
+
+	ASSERT (!(table[PDX (va)] & PTE_P) || (table[PDX (va)] & PTE_PS));
+	table[PDX (va)] = pa | flags | PTE_PS | PTE_P;
+	return true;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -122,7 +216,13 @@ pgdir_for_each (uint64_t *pdp, pte_for_each_func *func, void *aux,
 		unsigned pml4_index, unsigned pdp_index) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((pdp[i] & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS)) {
+			void *va = (void *) (((uint64_t) pml4_index << PML4SHIFT) |
+								 ((uint64_t) pdp_index << PDPESHIFT) |
+								 ((uint64_t) i << PDXSHIFT));
+			if (!func (&pdp[i], va, aux))
+				return false;
+		} else if (((uint64_t) pte) & PTE_P)
 			if (!pt_for_each ((uint64_t *) PTE_ADDR (pte), func, aux,
 					pml4_index, pdp_index, i))
 				return false;
@@ -143,7 +243,9 @@ pdp_for_each (uint64_t *pdp,
 	return true;
 }
 
-/* Apply FUNC to each available pte entries including kernel's. */
+/* Apply FUNC to each available pte entries including kernel's.
+ * For a 2 MB large page, FUNC is called once, with its page
+ * directory entry, which has PTE_PS set. */
 bool
 pml4_for_each (uint64_t *pml4, pte_for_each_func *func, void *aux) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
@@ -159,7 +261,7 @@ static void
 pt_destroy (uint64_t *pt) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pt[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if ((((uint64_t) pte) & (PTE_P | PTE_SHARED)) == PTE_P)
 			palloc_free_page ((void *) PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pt);
@@ -169,7 +271,13 @@ static void
 pgdir_destroy (uint64_t *pdp) {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *) pdp[i]);
-		if (((uint64_t) pte) & PTE_P)
+		if (!(((uint64_t) pte) & PTE_P))
+			continue;
+		if (((uint64_t) pte) & PTE_PS) {
+			if (!(((uint64_t) pte) & PTE_SHARED))
+				palloc_free_multiple ((void *) PTE_ADDR (pte),
+						LARGE_PGSIZE / PGSIZE);
+		} else
 			pt_destroy (PTE_ADDR (pte));
 	}
 	palloc_free_page ((void *) pdp);
@@ -192,6 +300,8 @@ pml4_destroy (uint64_t *pml4) {
 		return;
 	ASSERT (pml4 != base_pml4);
 
+	pcid_put (pml4);
+
 	/* if PML4 (vaddr) >= 1, it's kernel space by define. */
 	uint64_t *pdpe = ptov ((uint64_t *) pml4[0]);
 	if (((uint64_t) pdpe) & PTE_P)
@@ -199,11 +309,112 @@ pml4_destroy (uint64_t *pml4) {
 	palloc_free_page ((void *) pml4);
 }
 
+/* Turns on PCIDs if the CPU supports them.  Must be called with
+ * base_pml4 active. */
+void
+pml4_enable_pcid (void) {
+	uint32_t eax, ebx, ecx, edx;
+
+	__asm __volatile ("cpuid"
+			: "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+	if (!(ecx & CPUID_1_ECX_PCID))
+		return;
+
+	ASSERT ((rcr3 () & CR3_PCID_MASK) == 0);
+	for (unsigned i = 0; i < PCID_CNT; i++)
+		pcid_stale[i] = true;
+	lcr4 (rcr4 () | CR4_PCIDE);
+	pcid_enabled = true;
+}
+
+/* Returns PML4's PCID, assigning one first if it has none.  Sets
+ * *FLUSH to true if the PCID may have stale TLB entries.  Must be
+ * called with interrupts off. */
+static unsigned
+pcid_get (uint64_t *pml4, bool *flush) {
+	unsigned pcid = pml4[PCID_SLOT] >> PCID_SHIFT;
+	unsigned i;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (pcid == 0) {
+		/* Take a free PCID if there is one, otherwise the next one
+		 * round the pool that isn't loaded right now. */
+		for (i = 1; i < PCID_CNT; i++)
+			if (pcid_owner[i] == NULL) {
+				pcid = i;
+				break;
+			}
+		if (pcid == 0) {
+			do {
+				pcid = pcid_hand;
+				pcid_hand = pcid_hand % (PCID_CNT - 1) + 1;
+			} while (pcid == (rcr3 () & CR3_PCID_MASK));
+			pcid_owner[pcid][PCID_SLOT] = 0;
+			pcid_stale[pcid] = true;
+		}
+		pcid_owner[pcid] = pml4;
+		pml4[PCID_SLOT] = (uint64_t) pcid << PCID_SHIFT;
+	}
+
+	*flush = pcid_stale[pcid];
+	pcid_stale[pcid] = false;
+	return pcid;
+}
+
+/* Gives PML4's PCID, if any, back to the pool. */
+static void
+pcid_put (uint64_t *pml4) {
+	unsigned pcid = pml4[PCID_SLOT] >> PCID_SHIFT;
+
+	if (pcid != 0) {
+		enum intr_level old_level = intr_disable ();
+		ASSERT ((rcr3 () & CR3_PCID_MASK) != pcid);
+		pcid_owner[pcid] = NULL;
+		pcid_stale[pcid] = true;
+		intr_set_level (old_level);
+	}
+}
+
 /* Loads page directory PD into the CPU's page directory base
- * register. */
+ * register.  Does nothing if PD is already loaded.  With PCIDs,
+ * the TLB entries of the outgoing address space stay cached. */
 void
 pml4_activate (uint64_t *pml4) {
-	lcr3 (vtop (pml4 ? pml4 : base_pml4));
+	uint64_t cr3;
+	bool flush = false;
+
+	if (pml4 == NULL)
+		pml4 = base_pml4;
+	cr3 = vtop (pml4);
+
+	if (pcid_enabled) {
+		enum intr_level old_level = intr_disable ();
+
+		if (pml4 != base_pml4)
+			cr3 |= pcid_get (pml4, &flush);
+		if (flush)
+			lcr3 (cr3);
+		else if (rcr3 () != cr3)
+			lcr3 (cr3 | CR3_NOFLUSH);
+		intr_set_level (old_level);
+	} else if (rcr3 () != cr3)
+		lcr3 (cr3);
+}
+
+/* Invalidates any TLB entry for virtual page VPAGE in PML4,
+ * after its page table entry changed. */
+static void
+invalidate_page (uint64_t *pml4, const void *vpage) {
+	if (PTE_ADDR (rcr3 ()) == vtop (pml4))
+		invlpg ((uint64_t) vpage);
+	else if (pcid_enabled) {
+		/* Not loaded, but entries tagged with its PCID may still
+		 * be cached.  Flush them when it is loaded again. */
+		unsigned pcid = pml4[PCID_SLOT] >> PCID_SHIFT;
+		if (pcid != 0)
+			pcid_stale[pcid] = true;
+	}
 }
 
 /* Looks up the physical address that corresponds to user virtual
@@ -217,7 +428,8 @@ pml4_get_page (uint64_t *pml4, const void *uaddr) {
 	uint64_t *pte = pml4e_walk (pml4, (uint64_t) uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
-		return ptov (PTE_ADDR (*pte)) + pg_ofs (uaddr);
+		return ptov (PTE_ADDR (*pte)) + ((*pte & PTE_PS)
+				? large_pg_ofs (uaddr) : pg_ofs (uaddr));
 	return NULL;
 }
 
@@ -243,6 +455,58 @@ pml4_set_page (uint64_t *pml4, void *upage, void *kpage, bool rw) {
 	return pte != NULL;
 }
 
+/* Helper for pml4_set_pages() and pml4_share_pages(): maps pages
+ * with PTE_P | PTE_U and additional FLAGS. */
+static size_t
+set_pages (uint64_t *pml4, void *upage, void *kpage, size_t cnt,
+		uint64_t flags) {
+	uint64_t *pte = NULL;
+	size_t i;
+
+	ASSERT (pg_ofs (upage) == 0);
+	ASSERT (pg_ofs (kpage) == 0);
+	ASSERT (cnt == 0 || is_user_vaddr (upage + cnt * PGSIZE - 1));
+	ASSERT (pml4 != base_pml4);
+
+	for (i = 0; i < cnt; i++) {
+		uint64_t va = (uint64_t) upage + i * PGSIZE;
+
+		/* Consecutive pages share a page table until VA crosses
+		 * into the next one. */
+		if (pte == NULL || PTX (va) == 0) {
+			pte = pml4e_walk (pml4, va, 1);
+			if (pte == NULL)
+				break;
+		} else
+			pte++;
+
+		if (*pte & PTE_P)
+			break;
+		*pte = vtop (kpage + i * PGSIZE) | PTE_P | PTE_U | flags;
+	}
+	return i;
+}
+
+/* Maps the CNT consecutive user pages starting at UPAGE to the
+ * CNT consecutive kernel pages starting at KPAGE, like CNT calls to
+ * pml4_set_page() but walking the page table only once per 512
+ * pages.  Stops at the first page that is already mapped or whose
+ * page table cannot be allocated.  Returns the number of pages
+ * mapped; the rest are left as they were. */
+size_t
+pml4_set_pages (uint64_t *pml4, void *upage, void *kpage, size_t cnt,
+		bool rw) {
+	return set_pages (pml4, upage, kpage, cnt, rw ? PTE_W : 0);
+}
+
+/* Like pml4_set_pages(), but maps the pages read-only and marks
+ * them shared: pml4_destroy() leaves the frames alone, since they
+ * belong to someone else (see userprog/image.c). */
+size_t
+pml4_share_pages (uint64_t *pml4, void *upage, void *kpage, size_t cnt) {
+	return set_pages (pml4, upage, kpage, cnt, PTE_SHARED);
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -257,8 +521,7 @@ pml4_clear_page (uint64_t *pml4, void *upage) {
 
 	if (pte != NULL && (*pte & PTE_P) != 0) {
 		*pte &= ~PTE_P;
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) upage);
+		invalidate_page (pml4, upage);
 	}
 }
 
@@ -283,8 +546,7 @@ pml4_set_dirty (uint64_t *pml4, const void *vpage, bool dirty) {
 		else
 			*pte &= ~(uint32_t) PTE_D;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		invalidate_page (pml4, vpage);
 	}
 }
 
@@ -309,7 +571,6 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 		else
 			*pte &= ~(uint32_t) PTE_A;
 
-		if (rcr3 () == vtop (pml4))
-			invlpg ((uint64_t) vpage);
+		invalidate_page (pml4, vpage);
 	}
 }
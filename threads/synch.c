@@ -31,6 +31,170 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
+#include "intrinsic.h"
+
+/* Returns true if A should leave its wait queue before B. */
+static bool
+wait_elem_first (const struct wait_elem *a, const struct wait_elem *b) {
+	return a->priority > b->priority
+		|| (a->priority == b->priority && a->seq < b->seq);
+}
+
+/* Joins heaps A and B, either of which may be null, and returns
+   the root of the result. */
+static struct wait_elem *
+meld (struct wait_elem *a, struct wait_elem *b) {
+	struct wait_elem *t;
+
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (wait_elem_first (b, a)) {
+		t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's first child. */
+	b->prev = a;
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	a->next = a->prev = NULL;
+	return a;
+}
+
+/* Joins the list of sibling heaps starting at FIRST into one and
+   returns its root: melds them in pairs from left to right, then
+   melds the pairs together from right to left.  The two passes are
+   what keep pops O(log n) amortized. */
+static struct wait_elem *
+meld_siblings (struct wait_elem *first) {
+	struct wait_elem *pairs = NULL, *a, *b, *root;
+
+	/* First pass.  Chain the melded pairs in reverse through
+	   `next'. */
+	while (first != NULL) {
+		a = first;
+		b = a->next;
+		first = b != NULL ? b->next : NULL;
+		a->next = NULL;
+		if (b != NULL)
+			b->next = NULL;
+		a = meld (a, b);
+		a->next = pairs;
+		pairs = a;
+	}
+
+	/* Second pass. */
+	root = NULL;
+	while (pairs != NULL) {
+		a = pairs;
+		pairs = a->next;
+		a->next = NULL;
+		root = meld (root, a);
+	}
+	return root;
+}
+
+/* Unlinks E, with its subtree, from its parent or siblings.  E
+   must not be the root. */
+static void
+cut (struct wait_elem *e) {
+	if (e->prev->child == e)
+		e->prev->child = e->next;
+	else
+		e->prev->next = e->next;
+	if (e->next != NULL)
+		e->next->prev = e->prev;
+	e->next = e->prev = NULL;
+}
+
+/* Initializes Q as an empty wait queue. */
+void
+wait_queue_init (struct wait_queue *q) {
+	q->root = NULL;
+}
+
+/* Returns true if Q is empty. */
+bool
+wait_queue_empty (const struct wait_queue *q) {
+	return q->root == NULL;
+}
+
+/* Inserts E into Q with the given PRIORITY, behind any elements
+   already there with the same priority. */
+void
+wait_queue_push (struct wait_queue *q, struct wait_elem *e, int priority) {
+	static uint64_t next_seq;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (e->queue == NULL);
+
+	e->child = e->next = e->prev = NULL;
+	e->queue = q;
+	e->priority = priority;
+	e->seq = next_seq++;
+	q->root = meld (q->root, e);
+}
+
+/* Removes and returns the first element of Q, which must not be
+   empty. */
+struct wait_elem *
+wait_queue_pop (struct wait_queue *q) {
+	struct wait_elem *e = q->root;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (e != NULL);
+
+	q->root = meld_siblings (e->child);
+	e->queue = NULL;
+	return e;
+}
+
+/* Gives E, which is in a wait queue, the new PRIORITY. */
+static void
+rekey (struct wait_elem *e, int priority) {
+	struct wait_queue *q = e->queue;
+	bool raised = priority > e->priority;
+
+	e->priority = priority;
+	if (e == q->root) {
+		if (!raised) {
+			/* It may no longer belong on top. */
+			q->root = meld_siblings (e->child);
+			e->child = NULL;
+			q->root = meld (q->root, e);
+		}
+	} else if (raised) {
+		/* Its subtree is still a valid heap, and it can only move
+		   up, so cut it off and meld it back in at the top. */
+		cut (e);
+		q->root = meld (q->root, e);
+	} else {
+		cut (e);
+		q->root = meld (q->root, meld_siblings (e->child));
+		e->child = NULL;
+		q->root = meld (q->root, e);
+	}
+}
+
+/* Moves thread T within the wait queues it is in, if any, after a
+   change to its priority. */
+void
+wait_queue_update (struct thread *t) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->wait_elem.queue != NULL && t->wait_elem.priority != t->priority)
+		rekey (&t->wait_elem, t->priority);
+	if (t->cond_elem != NULL && t->cond_elem->queue != NULL
+			&& t->cond_elem->priority != t->priority)
+		rekey (t->cond_elem, t->priority);
+	intr_set_level (old_level);
+}
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,7 +210,7 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	wait_queue_init (&sema->waiters);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -66,8 +230,13 @@ sema_down (struct semaphore *sema) {
 	ASSERT (!intr_context ());
 
 	old_level = intr_disable ();
+	if (sema->value == 0)
+		trace_event (TRACE_BLOCK, (uint64_t) sema,
+				(uint64_t) thread_current ()->wait_on_lock);
 	while (sema->value == 0) {
-		list_insert_ordered(&sema->waiters, &thread_current ()->elem, &cmp_priority, NULL);
+		struct thread *curr = thread_current ();
+
+		wait_queue_push (&sema->waiters, &curr->wait_elem, curr->priority);
 		thread_block ();
 	}
 	sema->value--;
@@ -111,11 +280,9 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters)) {
-		// Wait list가 우선 순위 순으로 정렬되도록
-		list_sort(&sema->waiters, &cmp_priority, NULL);
-
-		thread_unblock (list_entry (list_pop_front (&sema->waiters), struct thread, elem));
+	if (!wait_queue_empty (&sema->waiters)) {
+		// Wait queue는 donation으로 바뀐 우선순위까지 반영되어 있으므로 정렬 없이 맨 앞 스레드를 깨움
+		thread_unblock (wait_entry (wait_queue_pop (&sema->waiters), struct thread, wait_elem));
 	}
 	sema->value++;
 
@@ -181,6 +348,67 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	lock->stats = NULL;
+}
+
+/* Statistics for named locks. */
+#define LOCK_STATS_CNT 32
+static struct lock_stats lock_stats[LOCK_STATS_CNT];
+static size_t lock_stats_cnt;
+
+/* Initializes LOCK like lock_init(), and also gives it NAME and
+   keeps statistics on how contended it is, for lock_print_stats().
+   The statistics live as long as the kernel, so only use this for
+   locks that do too.  If too many locks have been named already,
+   LOCK gets no statistics. */
+void
+lock_init_named (struct lock *lock, const char *name) {
+	enum intr_level old_level;
+
+	lock_init (lock);
+
+	old_level = intr_disable ();
+	if (lock_stats_cnt < LOCK_STATS_CNT) {
+		lock->stats = &lock_stats[lock_stats_cnt++];
+		lock->stats->name = name;
+	}
+	intr_set_level (old_level);
+}
+
+/* Records in LOCK's statistics, if any, that the current thread
+   just acquired it after waiting WAIT cycles, or not at all if
+   !CONTENDED. */
+static void
+lock_acquired (struct lock *lock, bool contended, uint64_t wait) {
+	struct lock_stats *s = lock->stats;
+
+	if (s == NULL)
+		return;
+
+	s->acquire_cnt++;
+	if (contended) {
+		s->contended_cnt++;
+		s->wait_total += wait;
+		if (wait > s->wait_max)
+			s->wait_max = wait;
+	}
+	s->acquired_at = rdtsc ();
+}
+
+/* Prints statistics for the named locks. */
+void
+lock_print_stats (void) {
+	size_t i;
+
+	for (i = 0; i < lock_stats_cnt; i++) {
+		struct lock_stats *s = &lock_stats[i];
+
+		printf ("Lock %s: %llu acquires, %llu contended, "
+				"%llu cycles waiting (max %llu), "
+				"%llu cycles held (max %llu)\n",
+				s->name, s->acquire_cnt, s->contended_cnt,
+				s->wait_total, s->wait_max, s->hold_total, s->hold_max);
+	}
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -198,9 +426,13 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	struct thread *curr = thread_current();
+	enum intr_level old_level = intr_disable ();
+	bool contended = lock->holder != NULL;
+	uint64_t start = lock->stats != NULL ? rdtsc () : 0;
 
 	// 해당 lock의 holder가 존재하는지 확인
-	if (lock->holder != NULL) {
+	// holder들의 우선순위와 wait queue를 바꾸는 동안 인터럽트를 끔
+	if (contended) {
 		// 현재 스레드의 wait_on_lock 변수에 기다리는 lock의 주소 저장
 		curr->wait_on_lock = lock;
 
@@ -210,12 +442,18 @@ lock_acquire (struct lock *lock) {
 		// Priority Donation 수행
 		donate_priority();
 	}
+	intr_set_level (old_level);
 
+	/*
+		holder가 곧 lock을 놓을 것 같더라도 spin하지 않고 바로 block함
+		CPU가 하나뿐이라 기다리는 동안 holder가 실행될 수 없기 때문 (SMP가 생기면 spin 후 block하도록 바꿀 것)
+	*/
 	sema_down (&lock->semaphore);
 	curr->wait_on_lock = NULL;
 
 	// lock을 획득한 후 lock holder 갱신
 	lock->holder = curr;
+	lock_acquired (lock, contended, lock->stats != NULL ? rdtsc () - start : 0);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -232,8 +470,10 @@ lock_try_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	success = sema_try_down (&lock->semaphore);
-	if (success)
+	if (success) {
 		lock->holder = thread_current ();
+		lock_acquired (lock, false, 0);
+	}
 	return success;
 }
 
@@ -248,6 +488,14 @@ lock_release (struct lock *lock) {
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
+	if (lock->stats != NULL) {
+		uint64_t hold = rdtsc () - lock->stats->acquired_at;
+
+		lock->stats->hold_total += hold;
+		if (hold > lock->stats->hold_max)
+			lock->stats->hold_max = hold;
+	}
+
 	remove_with_lock(lock);
 	refresh_priority();
 
@@ -265,9 +513,9 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* One semaphore in a condition variable's wait queue. */
 struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
+	struct wait_elem elem;              /* Wait queue element. */
 	struct semaphore semaphore;         /* This semaphore. */
 };
 
@@ -278,7 +526,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	wait_queue_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -304,6 +552,8 @@ cond_init (struct condition *cond) {
 void
 cond_wait (struct condition *cond, struct lock *lock) {
 	struct semaphore_elem waiter;
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
@@ -314,13 +564,19 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	sema_init (&waiter.semaphore, 0);
 
 	// 조건 변수를 기다리는 대기열에 추가
-	list_insert_ordered(&cond->waiters, &(waiter.elem), &cmp_sem_priority, NULL);
+	// 기다리는 동안 donation으로 우선순위가 바뀌면 wait_queue_update()가 cond_elem으로 위치를 옮김
+	waiter.elem.queue = NULL;
+	old_level = intr_disable ();
+	wait_queue_push (&cond->waiters, &waiter.elem, curr->priority);
+	curr->cond_elem = &waiter.elem;
+	intr_set_level (old_level);
 
 	// lock을 놓아서 다른 스레드들이 자원에 접근할 수 있도록 해줌
 	lock_release (lock);
 
 	// 세마 다운을 하기 위해 기다림
 	sema_down (&waiter.semaphore);
+	curr->cond_elem = NULL;
 
 	// 세마 다운이 되면 lock을 얻게 됨
 	lock_acquire (lock);
@@ -340,11 +596,17 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)) {
-		list_sort(&cond->waiters, &cmp_sem_priority, NULL);
+	struct semaphore_elem *waiter = NULL;
+	enum intr_level old_level = intr_disable ();
 
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	if (!wait_queue_empty (&cond->waiters)) {
+		waiter = wait_entry (wait_queue_pop (&cond->waiters),
+				struct semaphore_elem, elem);
+	}
+	intr_set_level (old_level);
+
+	if (waiter != NULL) {
+		sema_up (&waiter->semaphore);
 	}
 }
 
@@ -359,26 +621,231 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL); 
 
-	while (!list_empty (&cond->waiters)) {
+	while (!wait_queue_empty (&cond->waiters)) {
 		cond_signal (cond, lock);
 	}
 }
 
+/* Initializes RW as a reader-writer lock, which any number of
+   threads may hold for reading at once, or one thread for writing.
+
+   Writers take precedence: once a writer is waiting, new readers
+   wait behind it.  Within readers and within writers, higher
+   priorities go first.  A thread waiting for an rwlock donates its
+   priority to every thread holding it, like a lock.
+
+   When an rwlock is released, it is handed straight to the threads
+   that get it next, so that no thread can slip in between.
+
+   Each thread may hold at most RWLOCK_HOLD_MAX rwlocks at a time. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	rw->writer = NULL;
+	rw->reader_cnt = 0;
+	list_init (&rw->readers);
+	wait_queue_init (&rw->read_waiters);
+	wait_queue_init (&rw->write_waiters);
+}
+
+/* Records in T that it holds RW, and returns the record. */
+static struct rwlock_hold *
+hold_rwlock (struct thread *t, struct rwlock *rw) {
+	struct rwlock_hold *h;
+
+	for (h = t->rwlock_holds; h < t->rwlock_holds + RWLOCK_HOLD_MAX; h++)
+		if (h->rwlock == NULL) {
+			h->rwlock = rw;
+			h->thread = t;
+			return h;
+		}
+	PANIC ("%s holds too many rwlocks", t->name);
+}
+
+/* Removes the record that T holds RW, and returns it. */
+static struct rwlock_hold *
+unhold_rwlock (struct thread *t, struct rwlock *rw) {
+	struct rwlock_hold *h;
+
+	for (h = t->rwlock_holds; h < t->rwlock_holds + RWLOCK_HOLD_MAX; h++)
+		if (h->rwlock == rw) {
+			h->rwlock = NULL;
+			return h;
+		}
+	NOT_REACHED ();
+}
+
+/* Gives RW to T for reading. */
+static void
+grant_read (struct rwlock *rw, struct thread *t) {
+	list_push_back (&rw->readers, &hold_rwlock (t, rw)->elem);
+	rw->reader_cnt++;
+	t->wait_on_rwlock = NULL;
+}
+
+/* Gives RW to T for writing. */
+static void
+grant_write (struct rwlock *rw, struct thread *t) {
+	hold_rwlock (t, rw);
+	rw->writer = t;
+	t->wait_on_rwlock = NULL;
+}
+
+/* Blocks the current thread in Q, one of RW's wait queues, until
+   a releasing thread hands it RW. */
+static void
+wait_rwlock (struct rwlock *rw, struct wait_queue *q) {
+	struct thread *curr = thread_current ();
+
+	trace_event (TRACE_BLOCK, (uint64_t) rw, 0);
+	curr->wait_on_rwlock = rw;
+	wait_queue_push (q, &curr->wait_elem, curr->priority);
+	donate_priority ();
+	thread_block ();
+	ASSERT (curr->wait_on_rwlock == NULL);
+}
+
+/* Hands RW, which is free, to the first waiting writer if there
+   is one, otherwise to all the waiting readers. */
+static void
+hand_off_rwlock (struct rwlock *rw) {
+	struct thread *t;
+
+	if (!wait_queue_empty (&rw->write_waiters)) {
+		t = wait_entry (wait_queue_pop (&rw->write_waiters),
+				struct thread, wait_elem);
+		grant_write (rw, t);
+
+		/* Whoever is still waiting now waits for T. */
+		thread_donate (t, rwlock_waiter_priority (rw), 1);
+		thread_unblock (t);
+	} else {
+		while (!wait_queue_empty (&rw->read_waiters)) {
+			t = wait_entry (wait_queue_pop (&rw->read_waiters),
+					struct thread, wait_elem);
+			grant_read (rw, t);
+			thread_unblock (t);
+		}
+	}
+}
+
+/* Acquires RW for reading, sleeping until no writer holds it or
+   is waiting for it.  The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->writer != thread_current ());
+
+	old_level = intr_disable ();
+	if (rw->writer == NULL && wait_queue_empty (&rw->write_waiters))
+		grant_read (rw, thread_current ());
+	else
+		wait_rwlock (rw, &rw->read_waiters);
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (rw->writer != thread_current ());
+
+	old_level = intr_disable ();
+	if (rw->writer == NULL && rw->reader_cnt == 0)
+		grant_write (rw, thread_current ());
+	else
+		wait_rwlock (rw, &rw->write_waiters);
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread holds for reading. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rw->reader_cnt > 0);
+
+	old_level = intr_disable ();
+	list_remove (&unhold_rwlock (thread_current (), rw)->elem);
+	if (--rw->reader_cnt == 0)
+		hand_off_rwlock (rw);
+	refresh_priority ();
+	intr_set_level (old_level);
+
+	test_max_priority ();
+}
+
+/* Releases RW, which the current thread holds for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_write_held_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	unhold_rwlock (thread_current (), rw);
+	rw->writer = NULL;
+	hand_off_rwlock (rw);
+	refresh_priority ();
+	intr_set_level (old_level);
+
+	test_max_priority ();
+}
+
+/* Returns true if the current thread holds RW for writing, false
+   otherwise. */
 bool
-cmp_sem_priority(const struct list_elem *a,
-				 const struct list_elem *b,
-				 void *aux) {
+rwlock_write_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return rw->writer == thread_current ();
+}
 
-	struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
+/* Donates PRIORITY to every thread holding RW.  DEPTH is the
+   length of the donation chain so far.  Must be called with
+   interrupts off. */
+void
+rwlock_donate (struct rwlock *rw, int priority, int depth) {
+	struct list_elem *e;
 
-	// 세마포어의 waiters는 이미 우선순위 순으로 정렬이 되어 있기 때문에
-	// 첫번째 elem을 통해 스레드를 가져와 비교함
-	struct list_elem *sa_e = list_begin(&(sa->semaphore.waiters));
-	struct list_elem *sb_e = list_begin(&(sb->semaphore.waiters));
+	ASSERT (intr_get_level () == INTR_OFF);
 
-	struct thread *sa_t = list_entry(sa_e, struct thread, elem);
-	struct thread *sb_t = list_entry(sb_e, struct thread, elem);
+	if (rw->writer != NULL)
+		thread_donate (rw->writer, priority, depth);
+	for (e = list_begin (&rw->readers); e != list_end (&rw->readers);
+			e = list_next (e))
+		thread_donate (list_entry (e, struct rwlock_hold, elem)->thread,
+				priority, depth);
+}
 
-	return (sa_t->priority) > (sb_t->priority);
-}
\ No newline at end of file
+/* Returns the highest priority among threads waiting for RW, or
+   PRI_MIN if there are none.  Must be called with interrupts
+   off. */
+int
+rwlock_waiter_priority (const struct rwlock *rw) {
+	int priority = PRI_MIN;
+
+	if (!wait_queue_empty (&rw->read_waiters)
+			&& rw->read_waiters.root->priority > priority)
+		priority = rw->read_waiters.root->priority;
+	if (!wait_queue_empty (&rw->write_waiters)
+			&& rw->write_waiters.root->priority > priority)
+		priority = rw->write_waiters.root->priority;
+	return priority;
+}
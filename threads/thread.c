@@ -7,8 +7,10 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #ifdef USERPROG
@@ -45,6 +47,14 @@ static struct thread *initial_thread;
 /* Lock used by allocate_tid(). */
 static struct lock tid_lock;
 
+/* Thread pages of dead threads kept for reuse by thread_create(),
+   so that worker churn skips palloc's bitmap and page zeroing.
+   Accessed only with interrupts off.  There is one CPU, so this is
+   the per-CPU cache. */
+#define THREAD_CACHE_MAX 16
+static struct thread *thread_cache[THREAD_CACHE_MAX];
+static size_t thread_cache_cnt;
+
 /* Thread destruction requests */
 static struct list destruction_req;
 
@@ -68,6 +78,12 @@ static void idle (void *aux UNUSED);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
+static tid_t create_thread (const char *, int, thread_func *, void *,
+		bool joinable);
+static struct thread *alloc_thread_page (void);
+static void free_thread_page (struct thread *);
+static bool init_children (struct thread *);
+static void release_children (struct thread *);
 static void schedule (void);
 static tid_t allocate_tid (void);
 
@@ -116,7 +132,7 @@ thread_init (void) {
 	lgdt (&gdt_ds);
 
 	/* Init the globla thread context */
-	lock_init (&tid_lock);
+	lock_init_named (&tid_lock, "tid_lock");
 	list_init (&ready_list);
 	list_init (&destruction_req);
 
@@ -190,23 +206,44 @@ thread_print_stats (void) {
 
    The code provided sets the new thread's `priority' member to
    PRIORITY, but no actual priority scheduling is implemented.
-   Priority scheduling is the goal of Problem 1-3. */
+   Priority scheduling is the goal of Problem 1-3.
+
+   The new thread is detached: nobody can wait for it, and nothing
+   of it is left once it exits.  Use thread_create_joinable() for
+   threads that their creator will wait for. */
 tid_t
 thread_create (const char *name, int priority,
 		thread_func *function, void *aux) {
+	return create_thread (name, priority, function, aux, false);
+}
+
+/* Like thread_create(), but also gives the new thread a
+   child_status record in the creator's table of children, so that
+   the creator can find it with thread_find_child() and wait for its
+   exit code. */
+tid_t
+thread_create_joinable (const char *name, int priority,
+		thread_func *function, void *aux) {
+	return create_thread (name, priority, function, aux, true);
+}
+
+static tid_t
+create_thread (const char *name, int priority,
+		thread_func *function, void *aux, bool joinable) {
 	struct thread *t;
 	tid_t tid;
 
 	ASSERT (function != NULL);
 
 	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	t = alloc_thread_page ();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+	trace_thread_name (tid, t->name);
 
 	/*
 		Project 2: System Call
@@ -217,23 +254,29 @@ thread_create (const char *name, int priority,
 		4) 자식 리스트에 추가
 	*/
 
-	// 생성한 자식을 부모의 자식 리스트(child_elem)에 넣음, 그래야 나중에 부모의 자식 리스트에서 찾을 수 있음
-	struct thread *curr = thread_current();
-	list_push_back(&curr->child_list, &t->child_elem);
-
-	// fd 값 초기화 후, fdt에 메모리 할당
-	t->fd_table = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
-    if(t->fd_table == NULL) {
-		return TID_ERROR;
+	/*
+		부모와 공유하는 종료 기록(child_status)을 만들어 부모의 children 해시에 넣음
+		자식의 스레드 페이지는 종료 즉시 해제되고, 부모는 wait()에서 이 기록만 봄
+		detached 스레드는 기록을 만들지 않음
+	*/
+	if (joinable) {
+		struct thread *curr = thread_current();
+		struct child_status *cs = malloc(sizeof *cs);
+
+		if (cs == NULL || !init_children(curr)) {
+			free(cs);
+			free_thread_page(t);
+			return TID_ERROR;
+		}
+		cs->tid = tid;
+		cs->exit_status = 0;
+		cs->ref_cnt = 2;
+		sema_init(&cs->fork_sema, 0);
+		sema_init(&cs->exit_sema, 0);
+		t->child_status = cs;
+		hash_insert(&curr->children, &cs->elem);
 	}
 
-    t->fd_table[0] = 1;
-    t->fd_table[1] = 2;
-    t->fd_index = 2;
-
-    t->stdin_count = 1;
-    t->stdout_count = 1;
-
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	/*
@@ -286,6 +329,7 @@ thread_unblock (struct thread *t) {
 
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
+	trace_event (TRACE_WAKEUP, t->tid, 0);
 	list_insert_ordered(&ready_list , &t->elem, &cmp_priority, NULL);
 	t->status = THREAD_READY;
 	intr_set_level (old_level);
@@ -331,6 +375,16 @@ thread_exit (void) {
 	process_exit ();
 #endif
 
+	/* Publish our exit code to the parent and drop our references to
+	   our own record and to our children's. */
+	struct thread *curr = thread_current ();
+	release_children (curr);
+	if (curr->child_status != NULL) {
+		curr->child_status->exit_status = curr->exit_status;
+		sema_up (&curr->child_status->exit_sema);
+		child_status_release (curr->child_status);
+	}
+
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
@@ -466,11 +520,8 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->wait_on_lock = NULL;
 
 	// System Call 관련 인자들을 초기화 시켜줌
-	list_init(&t->child_list);
-    sema_init(&t->wait_sema, 0);
-    sema_init(&t->fork_sema, 0);
-    sema_init(&t->free_sema, 0);
-	
+	// children 해시는 malloc을 쓰므로 첫 joinable 자식을 만들 때 초기화
+    t->children_ready = false;
     t->exit_status = 0;
     t->running = NULL;
 }
@@ -601,7 +652,7 @@ do_schedule(int status) {
 	ASSERT (thread_current()->status == THREAD_RUNNING);
 	while (!list_empty (&destruction_req)) {
 		struct thread *victim = list_entry (list_pop_front (&destruction_req), struct thread, elem);
-		palloc_free_page(victim);
+		free_thread_page(victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -642,6 +693,8 @@ schedule (void) {
 		/* Before switching the thread, we first save the information
 		 * of current running. */
 
+		trace_thread_event (curr->tid, TRACE_SCHEDULE, next->tid, curr->status);
+
 		// 다음 스레드들을 활성화시킴
 		thread_launch (next);
 	}
@@ -686,6 +739,8 @@ int thread_sleep(int64_t ticks) {
 }
 
 // thread_awake: Sleep 리스트에서 깨워야 할 스레드 하나를 찾아 깨움
+// 타이머 softirq에서 인터럽트가 켜진 채로 호출됨.
+// sleep_list는 인터럽트를 끈 thread_sleep()과 softirq에서만 건드리므로 둘이 겹칠 일은 없음
 int thread_awake(int64_t ticks) {
 	struct list_elem *e = list_begin(&sleep_list);
 	struct thread *curr;
@@ -700,13 +755,16 @@ int thread_awake(int64_t ticks) {
 			e = list_remove(&curr->elem);
 			thread_unblock(curr);
 		} else {
-			// 하나를 내보냈으니, 새로운 리스트의 최소 Wake Time 업데이트
+			// 남은 스레드들 중 최소 Wake Time 계산
 			new_min = MIN(new_min, curr->wake_time);
-			min_time_in_sleep = new_min;
 
 			e = list_next(e);
 		}
-	} 
+	}
+
+	// 다 깨웠으면 INT64_MAX가 되어 타이머가 매 틱마다 softirq를 올리지 않음
+	min_time_in_sleep = new_min;
+	return 0;
 }
 
 // get_min_time: Sleep 리스트에 있는 최소 Wake Time 리턴
@@ -729,7 +787,7 @@ bool cmp_priority (const struct list_elem *a,
 
 // test_max_priority: 현재 스레드와 우선순위가 가장 높은 스레드를 비교하여 스케줄링
 void test_max_priority(){
-	if (list_empty(&ready_list) || intr_context()) {
+	if (list_empty(&ready_list)) {
 		return;
 	}
     
@@ -738,27 +796,53 @@ void test_max_priority(){
 	struct thread *t = list_entry(e, struct thread, elem);
     
 	if (run_priority < t->priority) {
-		thread_yield();
+		// 인터럽트/softirq 안에서는 양보할 수 없으니 인터럽트가 리턴할 때 양보
+		if (intr_context())
+			intr_yield_on_return();
+		else
+			thread_yield();
 	}
 }
 /*
 	donate_priority: 현재 스레드가 기다리고 있는 lock과 연결된 모든 스레드를 순회,
 	현재 스레드의 우선 순위를 lock 보유 스레드들에게 기부
+
+	기다리는 것이 rwlock이면 rwlock을 가진 모든 스레드(writer 또는 모든 reader)에게 기부
+	인터럽트가 꺼진 상태에서 호출해야 함
 */
 void donate_priority() {
-	int cnt = 0;
 	struct thread *curr = thread_current();
-	int original_priority = curr->priority;
 
-	while (cnt < 9)	{
-		cnt++;
+	ASSERT (intr_get_level () == INTR_OFF);
 
-		if (curr->wait_on_lock == NULL) {
-			break;
-		}
+	if (curr->wait_on_lock != NULL && curr->wait_on_lock->holder != NULL) {
+		thread_donate(curr->wait_on_lock->holder, curr->priority, 1);
+	} else if (curr->wait_on_rwlock != NULL) {
+		rwlock_donate(curr->wait_on_rwlock, curr->priority, 1);
+	}
+}
+
+/*
+	thread_donate: 스레드 t에게 priority를 기부, depth는 지금까지의 기부 체인 길이 (최대 9단계)
+
+	기부는 우선순위를 올리기만 함 (이미 더 높은 스레드를 만나면 그 뒤로는 올릴 필요가 없음)
+	t가 다른 세마포어나 조건 변수를 기다리는 중이면 wait_queue_update()로 wait queue 안의 위치도 갱신
+	t도 lock이나 rwlock을 기다리는 중이면 그 holder들에게 이어서 기부
+*/
+void thread_donate(struct thread *t, int priority, int depth) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (depth > 9 || t->priority >= priority) {
+		return;
+	}
+
+	t->priority = priority;
+	wait_queue_update(t);
 
-		curr = curr->wait_on_lock->holder;
-		curr->priority = original_priority;
+	if (t->wait_on_lock != NULL && t->wait_on_lock->holder != NULL) {
+		thread_donate(t->wait_on_lock->holder, priority, depth + 1);
+	} else if (t->wait_on_rwlock != NULL) {
+		rwlock_donate(t->wait_on_rwlock, priority, depth + 1);
 	}
 }
 
@@ -793,15 +877,25 @@ void refresh_priority(void) {
 
 	// 우선 순위가 가장 높은 donations 리스트의 스레드와
 	// 현재 스레드의 우선 순위를 비교하여 높은 값을 현재 스레드의 우선순위로 설정
+	// donations 리스트를 정렬하지 않고 가장 높은 스레드만 찾음 (O(n))
 	if (list_empty(&curr->donations) == false) {
-		list_sort(&curr->donations, &cmp_priority, NULL);
-
-		struct thread* max_thread = list_entry(list_begin(&curr->donations), struct thread, donation_elem);
+		struct thread* max_thread = list_entry(list_min(&curr->donations, &cmp_donation_priority, NULL), struct thread, donation_elem);
 		
 		if (curr->priority < max_thread->priority) {
 			curr->priority = max_thread->priority;
 		}
 	}
+
+	// 현재 스레드가 가진 rwlock들을 기다리는 스레드들의 우선순위도 반영
+	enum intr_level old_level = intr_disable();
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++) {
+		struct rwlock *rw = curr->rwlock_holds[i].rwlock;
+
+		if (rw != NULL && curr->priority < rwlock_waiter_priority(rw)) {
+			curr->priority = rwlock_waiter_priority(rw);
+		}
+	}
+	intr_set_level(old_level);
 }
 
 bool cmp_donation_priority (const struct list_elem *a,
@@ -815,4 +909,109 @@ bool cmp_donation_priority (const struct list_elem *a,
 	} else {
 		return false;
 	}
-}
\ No newline at end of file
+}
+
+/* Returns a page for a new thread, preferably one recycled from a
+   dead thread.  The page is not zeroed: init_thread() clears the
+   struct thread header, and the rest is stack. */
+static struct thread *
+alloc_thread_page (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (thread_cache_cnt > 0)
+		t = thread_cache[--thread_cache_cnt];
+	intr_set_level (old_level);
+
+	return t != NULL ? t : palloc_get_page (0);
+}
+
+/* Returns thread page T to the cache, or to the page allocator if
+   the cache is full. */
+static void
+free_thread_page (struct thread *t) {
+	enum intr_level old_level;
+	bool cached = false;
+
+	old_level = intr_disable ();
+	if (thread_cache_cnt < THREAD_CACHE_MAX) {
+		thread_cache[thread_cache_cnt++] = t;
+		cached = true;
+	}
+	intr_set_level (old_level);
+
+	if (!cached)
+		palloc_free_page (t);
+}
+
+/* child_status 관련 함수들 */
+
+static uint64_t
+child_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct child_status *cs = hash_entry (e, struct child_status, elem);
+	return hash_int (cs->tid);
+}
+
+static bool
+child_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct child_status, elem)->tid
+		< hash_entry (b, struct child_status, elem)->tid;
+}
+
+/* Initializes T's table of children, if it has not been already.
+   This is put off until T creates its first joinable child, so
+   that other threads never allocate one.  Returns false if out of
+   memory. */
+static bool
+init_children (struct thread *t) {
+	if (!t->children_ready)
+		t->children_ready = hash_init (&t->children, child_hash, child_less,
+				NULL);
+	return t->children_ready;
+}
+
+static void
+release_child (struct hash_elem *e, void *aux UNUSED) {
+	child_status_release (hash_entry (e, struct child_status, elem));
+}
+
+/* Drops T's references to the records of all of its children,
+   waited for or not. */
+static void
+release_children (struct thread *t) {
+	if (t->children_ready) {
+		hash_destroy (&t->children, release_child);
+		t->children_ready = false;
+	}
+}
+
+/* Returns the running thread's record for child TID, or a null
+   pointer if TID is not a child of the running thread or has
+   already been waited for. */
+struct child_status *
+thread_find_child (tid_t tid) {
+	struct child_status key;
+	struct hash_elem *e;
+
+	if (!thread_current ()->children_ready)
+		return NULL;
+	key.tid = tid;
+	e = hash_find (&thread_current ()->children, &key.elem);
+	return e != NULL ? hash_entry (e, struct child_status, elem) : NULL;
+}
+
+/* Drops one reference to CS, freeing it if that was the last. */
+void
+child_status_release (struct child_status *cs) {
+	enum intr_level old_level;
+	bool last;
+
+	old_level = intr_disable ();
+	last = --cs->ref_cnt == 0;
+	intr_set_level (old_level);
+
+	if (last)
+		free (cs);
+}
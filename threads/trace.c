@@ -0,0 +1,149 @@
+#include "threads/trace.h"
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+#ifdef FILESYS
+#include "filesys/file.h"
+#endif
+
+/* Event trace.
+
+   Events go into a ring buffer that overwrites the oldest entry
+   when full.  Recording takes no lock and leaves interrupts
+   alone: a writer reserves a slot by atomically incrementing the
+   head, so an interrupt handler that records an event while a
+   thread is halfway through recording one simply gets the next
+   slot.  Pintos runs on a single CPU, so there is one ring; with
+   more CPUs each would get its own, indexed by CPU number.
+
+   Recording is cheap enough (an rdtsc and a few stores) to leave
+   on all the time.  The -no-trace kernel option turns it off. */
+
+#define TRACE_PAGE_CNT \
+	DIV_ROUND_UP (TRACE_EVENT_CNT * sizeof (struct trace_event), PGSIZE)
+
+/* A ring of events. */
+struct trace_ring {
+	struct trace_event *events; /* TRACE_EVENT_CNT events, or null. */
+	uint64_t head;              /* Number of events ever recorded. */
+	bool paused;                /* Drop events while dumping? */
+};
+
+static struct trace_ring ring;
+
+/* When tracing started. */
+static uint64_t tsc_start;
+static int64_t ticks_start;
+
+/* Starts recording events. */
+void
+trace_init (void) {
+	ring.events = palloc_get_multiple (PAL_ZERO, TRACE_PAGE_CNT);
+	if (ring.events == NULL)
+		return;
+	tsc_start = rdtsc ();
+	ticks_start = timer_ticks ();
+	trace_thread_name (thread_current ()->tid, thread_current ()->name);
+}
+
+/* Reserves a slot in the ring and stamps it with the time, TYPE
+   and TID.  Returns null if tracing is off. */
+static struct trace_event *
+reserve (tid_t tid, enum trace_type type) {
+	struct trace_event *e;
+
+	if (ring.events == NULL || ring.paused)
+		return NULL;
+	e = &ring.events[__atomic_fetch_add (&ring.head, 1, __ATOMIC_RELAXED)
+		% TRACE_EVENT_CNT];
+	e->tsc = rdtsc ();
+	e->type = type;
+	e->tid = tid;
+	return e;
+}
+
+/* Records an event of the given TYPE and arguments in the thread
+   identified by TID. */
+void
+trace_thread_event (tid_t tid, enum trace_type type,
+		uint64_t arg0, uint64_t arg1) {
+	struct trace_event *e = reserve (tid, type);
+
+	if (e != NULL) {
+		e->arg[0] = arg0;
+		e->arg[1] = arg1;
+	}
+}
+
+/* Records an event of the given TYPE and arguments in the running
+   thread. */
+void
+trace_event (enum trace_type type, uint64_t arg0, uint64_t arg1) {
+	if (ring.events != NULL)
+		trace_thread_event (thread_current ()->tid, type, arg0, arg1);
+}
+
+/* Records that the thread identified by TID is named NAME, so that
+   readers can label its events. */
+void
+trace_thread_name (tid_t tid, const char *name) {
+	struct trace_event *e = reserve (tid, TRACE_THREAD_NAME);
+
+	if (e != NULL)
+		strlcpy ((char *) e->arg, name, sizeof e->arg);
+}
+
+#ifdef FILESYS
+/* Writes the events in the ring, oldest first, to FILE at its
+   current position, in the format described in <trace-event.h>.
+   Files do not grow, so if FILE is too short for all the events,
+   writes only the most recent ones that fit.  Events that happen
+   meanwhile are not recorded.  Returns the number of bytes
+   written, or -1 if tracing is off or FILE has no room. */
+off_t
+trace_write (struct file *file) {
+	struct trace_header h;
+	uint64_t first, head, start, cnt;
+	off_t room, size;
+
+	room = file_length (file) - file_tell (file) - (off_t) sizeof h;
+	if (ring.events == NULL || room < 0)
+		return -1;
+	room /= sizeof (struct trace_event);
+
+	ring.paused = true;
+	head = ring.head;
+	first = head > TRACE_EVENT_CNT ? head - TRACE_EVENT_CNT : 0;
+	if (head - first > (uint64_t) room)
+		first = head - room;
+
+	memcpy (h.magic, TRACE_MAGIC, sizeof h.magic);
+	h.version = TRACE_VERSION;
+	h.event_size = sizeof (struct trace_event);
+	h.event_cnt = head - first;
+	h.lost_cnt = first;
+	h.tsc_start = tsc_start;
+	h.tsc_end = rdtsc ();
+	h.ticks_start = ticks_start;
+	h.ticks_end = timer_ticks ();
+	h.timer_freq = TIMER_FREQ;
+	size = file_write (file, &h, sizeof h);
+
+	/* The ring wraps at most once between FIRST and HEAD. */
+	for (; first < head; first += cnt) {
+		start = first % TRACE_EVENT_CNT;
+		cnt = head - first;
+		if (cnt > TRACE_EVENT_CNT - start)
+			cnt = TRACE_EVENT_CNT - start;
+		size += file_write (file, &ring.events[start],
+				cnt * sizeof (struct trace_event));
+	}
+
+	ring.paused = false;
+	return size;
+}
+#endif
@@ -2,8 +2,10 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/usercopy.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/trace.h"
 #include "intrinsic.h"
 
 /* Number of page faults processed. */
@@ -129,6 +131,7 @@ page_fault (struct intr_frame *f) {
 	   that caused the fault (that's f->rip). */
 
 	fault_addr = (void *) rcr2();
+	trace_event (TRACE_PAGE_FAULT, (uint64_t) fault_addr, f->error_code);
 
 	/* Turn interrupts back on (they were only off so that we could
 	   be assured of reading CR2 before it changed). */
@@ -149,6 +152,17 @@ page_fault (struct intr_frame *f) {
 	/* Count page faults. */
 	page_fault_cnt++;
 
+	/* A kernel fault inside one of the user memory accessors is the
+	   user's fault, not ours: resume at the accessor's recovery
+	   point and let it report failure to its caller. */
+	if (!user) {
+		uintptr_t fixup = search_exception_table (f->rip);
+		if (fixup != 0) {
+			f->rip = fixup;
+			return;
+		}
+	}
+
 	/* If the fault is true fault, show info and exit. */
 	printf ("Page fault at %p: %s error %s page in %s context.\n",
 			fault_addr,
@@ -0,0 +1,256 @@
+#include "userprog/image.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Executable image cache.
+
+   Running the same program again, as fork-and-exec loops and
+   recursive tests do, used to open, parse and read the whole file
+   each time.  The cache keeps the parsed segment table of recently
+   run executables along with their read-only segments already in
+   memory; load() maps those frames read-only into each new process
+   instead of reading them again, so N copies of a program share
+   one copy of its text.  Writable segments are still loaded per
+   process.
+
+   Images are keyed by inode.  While a process runs an image, its
+   file cannot be written (see file_deny_write()); once nobody runs
+   it, a write bumps the inode's write generation and the stale
+   image is dropped on the next lookup. */
+
+/* Maximum number of images kept cached. */
+#define IMAGE_CACHE_MAX 8
+
+static struct list images;      /* Most recently used first. */
+static size_t image_cnt;        /* Number of images in IMAGES. */
+static struct lock image_lock;  /* Protects everything here. */
+
+/* Statistics. */
+static long long hit_cnt, miss_cnt, evict_cnt;
+
+static struct image *find_image (struct inode *);
+static bool evict_one (void);
+static void uncache (struct image *);
+static void free_image (struct image *);
+
+/* Initializes the image cache. */
+void
+image_init (void) {
+	list_init (&images);
+	lock_init_named (&image_lock, "image_lock");
+}
+
+/* Returns the cached image of FILE with a new reference, or a null
+   pointer if FILE is not cached. */
+struct image *
+image_lookup (struct file *file) {
+	struct image *img;
+
+	lock_acquire (&image_lock);
+	img = find_image (file_get_inode (file));
+	if (img != NULL) {
+		img->ref_cnt++;
+		hit_cnt++;
+	} else
+		miss_cnt++;
+	lock_release (&image_lock);
+
+	return img;
+}
+
+/* Adds FILE to the cache, with entry point ENTRY and the SEG_CNT
+   segments in SEGS, reading its read-only segments into memory.
+   Returns the new image with one reference, or a null pointer if
+   memory is short, in which case the caller should load FILE
+   privately.  If FILE was cached meanwhile, returns that image. */
+struct image *
+image_create (struct file *file, uint64_t entry,
+		const struct load_seg *segs, size_t seg_cnt) {
+	struct inode *inode = file_get_inode (file);
+	struct image *img;
+	size_t i;
+
+	lock_acquire (&image_lock);
+	img = find_image (inode);
+	if (img != NULL) {
+		img->ref_cnt++;
+		goto done;
+	}
+
+	img = calloc (1, sizeof *img);
+	if (img == NULL)
+		goto done;
+	img->segs = calloc (seg_cnt > 0 ? seg_cnt : 1, sizeof *img->segs);
+	if (img->segs == NULL) {
+		free (img);
+		img = NULL;
+		goto done;
+	}
+	img->seg_cnt = seg_cnt;
+
+	for (i = 0; i < seg_cnt; i++) {
+		const struct load_seg *seg = &segs[i];
+		size_t page_cnt = (seg->read_bytes + seg->zero_bytes) / PGSIZE;
+		uint8_t *frames;
+
+		img->segs[i].seg = *seg;
+		if (seg->writable)
+			continue;
+
+		/* Make room by evicting unused images if we must. */
+		while ((frames = palloc_get_multiple (PAL_USER, page_cnt)) == NULL)
+			if (!evict_one ())
+				break;
+		if (frames == NULL
+				|| file_read_at (file, frames, seg->read_bytes, seg->file_page)
+				!= (off_t) seg->read_bytes) {
+			if (frames != NULL)
+				palloc_free_multiple (frames, page_cnt);
+			free_image (img);
+			img = NULL;
+			goto done;
+		}
+		memset (frames + seg->read_bytes, 0, seg->zero_bytes);
+		img->segs[i].frames = frames;
+		img->frame_cnt += page_cnt;
+	}
+
+	img->inode = inode_reopen (inode);
+	img->write_gen = inode_write_gen (inode);
+	img->entry = entry;
+	img->ref_cnt = 1;
+
+	while (image_cnt >= IMAGE_CACHE_MAX && evict_one ())
+		continue;
+	img->cached = true;
+	list_push_front (&images, &img->elem);
+	image_cnt++;
+
+done:
+	lock_release (&image_lock);
+	return img;
+}
+
+/* Returns IMG with a new reference, for a forked child. */
+struct image *
+image_dup (struct image *img) {
+	lock_acquire (&image_lock);
+	img->ref_cnt++;
+	lock_release (&image_lock);
+	return img;
+}
+
+/* Drops a reference to IMG.  IMG stays cached for the next exec
+   unless it has already been dropped from the cache. */
+void
+image_release (struct image *img) {
+	lock_acquire (&image_lock);
+	ASSERT (img->ref_cnt > 0);
+	if (--img->ref_cnt == 0 && !img->cached)
+		free_image (img);
+	lock_release (&image_lock);
+}
+
+/* Frees the least recently used image that no process is running,
+   to give its frames back under memory pressure.  Returns true if
+   one was freed, false if there was none. */
+bool
+image_evict (void) {
+	bool evicted;
+
+	lock_acquire (&image_lock);
+	evicted = evict_one ();
+	lock_release (&image_lock);
+
+	return evicted;
+}
+
+/* Prints image cache statistics. */
+void
+image_print_stats (void) {
+	struct list_elem *e;
+	size_t frame_cnt = 0;
+
+	for (e = list_begin (&images); e != list_end (&images); e = list_next (e))
+		frame_cnt += list_entry (e, struct image, elem)->frame_cnt;
+	printf ("Image cache: %zu images, %zu shared frames, "
+			"%lld hits, %lld misses, %lld evictions\n",
+			image_cnt, frame_cnt, hit_cnt, miss_cnt, evict_cnt);
+}
+
+/* Returns the current cached image of INODE, moving it to the
+   front of the cache, or a null pointer if there is none.  Drops a
+   stale image of INODE found along the way.  The caller must hold
+   image_lock. */
+static struct image *
+find_image (struct inode *inode) {
+	struct list_elem *e;
+
+	for (e = list_begin (&images); e != list_end (&images); e = list_next (e)) {
+		struct image *img = list_entry (e, struct image, elem);
+
+		if (img->inode != inode)
+			continue;
+		if (img->write_gen != inode_write_gen (inode)) {
+			uncache (img);
+			return NULL;
+		}
+		list_remove (&img->elem);
+		list_push_front (&images, &img->elem);
+		return img;
+	}
+	return NULL;
+}
+
+/* Drops the least recently used unused image from the cache.
+   Returns true if successful.  The caller must hold image_lock. */
+static bool
+evict_one (void) {
+	struct list_elem *e;
+
+	for (e = list_rbegin (&images); e != list_rend (&images); e = list_prev (e)) {
+		struct image *img = list_entry (e, struct image, elem);
+
+		if (img->ref_cnt == 0) {
+			uncache (img);
+			evict_cnt++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Removes IMG from the cache, freeing it if no process uses it.
+   The caller must hold image_lock. */
+static void
+uncache (struct image *img) {
+	list_remove (&img->elem);
+	image_cnt--;
+	img->cached = false;
+	if (img->ref_cnt == 0)
+		free_image (img);
+}
+
+/* Frees IMG and its frames. */
+static void
+free_image (struct image *img) {
+	size_t i;
+
+	for (i = 0; i < img->seg_cnt; i++)
+		if (img->segs[i].frames != NULL) {
+			const struct load_seg *seg = &img->segs[i].seg;
+			palloc_free_multiple (img->segs[i].frames,
+					(seg->read_bytes + seg->zero_bytes) / PGSIZE);
+		}
+	if (img->inode != NULL)
+		inode_close (img->inode);
+	free (img->segs);
+	free (img);
+}
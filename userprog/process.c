@@ -7,12 +7,14 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
+#include "userprog/image.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -26,15 +28,35 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void __do_spawn (void *);
+static bool duplicate_fds (struct thread *parent,
+		const struct spawn_fd *, size_t fd_cnt);
 
 void push_arguments(int argc, char **argv, struct intr_frame *if_);
-struct thread *find_child(int pid);
 
 /* General process initializer for initd and other process. */
 // process_init: 현재 프로세스를 초기화하는 함수
-static void
+/*
+	fd 테이블은 유저 프로세스에만 필요하므로 thread_create()가 아니라 여기서 할당
+	커널 스레드는 fd 테이블 없이 생성됨, 메모리가 부족하면 false 리턴
+*/
+static bool
 process_init (void) {
 	struct thread *current = thread_current ();
+
+	current->fd_table = palloc_get_multiple(PAL_ZERO, FDT_PAGES);
+	if (current->fd_table == NULL) {
+		return false;
+	}
+
+	current->fd_table[0] = 1;
+	current->fd_table[1] = 2;
+	current->fd_index = 2;
+
+	current->stdin_count = 1;
+	current->stdout_count = 1;
+
+	return true;
 }
 
 /* Starts the first userland program, called "initd", loaded from FILE_NAME.
@@ -79,7 +101,7 @@ process_create_initd (const char *file_name) {
 		thread_create() + "file_name"
 		initd() + "fn_copy"
 	*/
-	tid = thread_create (file_name, PRI_DEFAULT, initd, fn_copy);
+	tid = thread_create_joinable (file_name, PRI_DEFAULT, initd, fn_copy);
 
 	if (tid == TID_ERROR)
 		palloc_free_page (fn_copy);
@@ -98,7 +120,8 @@ initd (void *f_name) {
 		process_init: 현재 프로세스를 초기화하는 함수
 		현재 실행중인 스레드가 있는지 확인하는 것 자체만으로도, 프로세스를 초기화하는 효과
 	*/
-	process_init ();
+	if (!process_init ())
+		PANIC("Fail to launch initd\n");
 
 	/*
 		process_exec: 실제로 사용자 프로그램을 실행시키는 함수
@@ -131,18 +154,19 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 		thread_create() + "name"
 		__do_fork() + "curr"
 	*/
-    tid_t pid = thread_create(name, PRI_DEFAULT, __do_fork, curr);
+    tid_t pid = thread_create_joinable(name, PRI_DEFAULT, __do_fork, curr);
 
     if (pid == TID_ERROR) {
         return TID_ERROR;
     }
 
-    struct thread *child = find_child(pid);
+    struct child_status *child = thread_find_child(pid);
 
 	/*
 		do_fork에서 fork sema up으로 막혀있었는데, fork sema down 해줌
 		자식 스레드가 생성되고 do_fork 완료할 때까지 fork()에서 대기한다는 의미
 		모두 완료되면, 자식 스레드의 tid를 리턴
+		자식 스레드는 이미 종료되어 해제되었을 수 있으므로, 공유하는 child_status만 봄
 	*/
     sema_down(&child->fork_sema);
 
@@ -154,6 +178,20 @@ process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 }
 
 #ifndef VM
+/* Allocates CNT contiguous user pages with palloc_get_multiple(),
+ * evicting unused executable images from the image cache while
+ * the user pool is exhausted.  Returns a null pointer if no pages
+ * can be freed up that way. */
+static void *
+get_user_pages (enum palloc_flags flags, size_t cnt) {
+	void *pages;
+
+	while ((pages = palloc_get_multiple (PAL_USER | flags, cnt)) == NULL)
+		if (!image_evict ())
+			break;
+	return pages;
+}
+
 /* Duplicate the parent's address space by passing this function to the
  * pml4_for_each. This is only for the project 2. */
 static bool
@@ -175,9 +213,13 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
         return false;
     }
 
+	/* image cache의 공유 프레임은 복사하지 않고 자식도 같은 프레임을 읽기 전용으로 매핑 */
+	if (*pte & PTE_SHARED)
+		return pml4_share_pages (current->pml4, va, parent_page, 1) == 1;
+
 	/* 3. TODO: Allocate new PAL_USER page for the child and set result to
 	 *    TODO: NEWPAGE. */
-	newpage = palloc_get_page (PAL_USER | PAL_ZERO);
+	newpage = get_user_pages (0, 1);
     if (newpage == NULL) {
         return false;
     }
@@ -186,7 +228,7 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {
 	 *    TODO: check whether parent's page is writable or not (set WRITABLE
 	 *    TODO: according to the result). */
 	// is_writable(): pte가 읽고 쓰기가 가능한지 확인
-	memcpy(newpage, parent_page, PGSIZE);
+	copy_page(newpage, parent_page);
     writable = is_writable(pte);
 
 	/* 5. Add new page to child's page table at address VA with WRITABLE
@@ -230,6 +272,9 @@ __do_fork (void *aux) {
 		goto error;
 
 	process_activate (current);
+	// 부모가 실행 중인 image를 같이 참조 (공유 프레임이 image에 속함)
+	if (parent->image != NULL)
+		current->image = image_dup (parent->image);
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
 	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
@@ -246,36 +291,162 @@ __do_fork (void *aux) {
 	 * TODO:       the resources of parent.*/
 
 	// Project 2: System Call
-	if (parent->fd_index >= FDCOUNT_LIMIT) {
+	if (parent->fd_index >= FDCOUNT_LIMIT || !process_init()) {
 		goto error;
 	}
 
+	if (!duplicate_fds (parent, NULL, 0))
+		goto error;
+
+	sema_up(&current->child_status->fork_sema);
+
+	/* Finally, switch to the newly created process. */
+	if (succ)
+		do_iret (&if_);
+error:
+	// Project 2: System Call
+	current->child_status->exit_status = TID_ERROR;
+    sema_up(&current->child_status->fork_sema);
+    exit(TID_ERROR);
+}
+
+/* Copies the parent's fds into the current process's fd table.
+ * With no FDS, duplicates all of them, as fork() does.  Otherwise
+ * the current process gets the console and, for each of the FD_CNT
+ * actions in FDS, the parent's PARENT_FD as CHILD_FD. */
+static bool
+duplicate_fds (struct thread *parent, const struct spawn_fd *fds,
+		size_t fd_cnt) {
+	struct thread *current = thread_current ();
+	size_t i;
+
 	current->fd_table[0] = parent->fd_table[0];
 	current->fd_table[1] = parent->fd_table[1];
 
-	for (int i = 2 ; i < FDCOUNT_LIMIT; i++) {
-        struct file *f = parent->fd_table[i];
+	if (fds == NULL) {
+		for (i = 2; i < FDCOUNT_LIMIT; i++) {
+			struct file *f = parent->fd_table[i];
 
-        if (f == NULL){
-            continue;
-        }
+			if (f == NULL)
+				continue;
 
-		// file.c의 file_duplicate() 사용
-        current->fd_table[i] = file_duplicate(f);
-    }
+			// file.c의 file_duplicate() 사용
+			current->fd_table[i] = file_duplicate (f);
+			if (current->fd_table[i] == NULL)
+				return false;
+		}
+		current->fd_index = parent->fd_index;
+		return true;
+	}
 
-	current->fd_index = parent->fd_index;
+	for (i = 0; i < fd_cnt; i++) {
+		struct file **slot = &current->fd_table[fds[i].child_fd];
 
-	sema_up(&current->fork_sema);
+		// 같은 child_fd가 여러 번 나오면 dup2()처럼 마지막 것이 이김
+		if (*slot != NULL)
+			file_close (*slot);
+		*slot = file_duplicate (parent->fd_table[fds[i].parent_fd]);
+		if (*slot == NULL)
+			return false;
+	}
+	current->fd_index = 2;
+	return true;
+}
+
+/* Arguments for __do_spawn(), on the parent's stack. */
+struct spawn_args {
+	struct thread *parent;
+	char *cmd_line;
+	const struct spawn_fd *fds;
+	size_t fd_cnt;
+};
+
+/* Starts a new process running CMD_LINE, a page from palloc_get_page()
+ * that this function frees, as a child of the current process.
+ * Unlike fork() followed by exec(), the current address space is
+ * not copied just to be thrown away: the child loads its executable
+ * directly.  FDS and FD_CNT select the fds the child gets, as in
+ * duplicate_fds().  Returns the child's thread id, or TID_ERROR if
+ * the child cannot be created or its executable cannot be loaded. */
+/*
+	process_spawn: fork() + exec()를 한 번에 하는 함수
+
+	fork()는 부모의 페이지를 전부 복사하고 fd도 전부 복제하지만, 바로 이어지는 exec()에서 모두 버려짐
+	spawn()은 자식 스레드가 처음부터 실행 파일을 로드하므로 복사할 것이 없음
+	자식은 부모가 지정한 fd만 넘겨 받음
+*/
+tid_t
+process_spawn (char *cmd_line, const struct spawn_fd *fds, size_t fd_cnt) {
+	struct thread *curr = thread_current ();
+	struct spawn_args args = {curr, cmd_line, fds, fd_cnt};
+	char name[16];
+	size_t i;
+	tid_t pid;
+
+	// 부모 쪽에서 fd를 먼저 검사, 잘못된 fd면 스레드를 만들지 않음
+	for (i = 0; i < fd_cnt; i++)
+		if (fds[i].child_fd < 2 || fds[i].child_fd >= FDCOUNT_LIMIT
+				|| fds[i].parent_fd < 2 || fds[i].parent_fd >= FDCOUNT_LIMIT
+				|| curr->fd_table[fds[i].parent_fd] == NULL) {
+			palloc_free_page (cmd_line);
+			return TID_ERROR;
+		}
+
+	// 스레드 이름은 실행 파일 이름 (cmd_line의 첫 단어)
+	for (i = 0; i < sizeof name - 1 && cmd_line[i] != ' '
+			&& cmd_line[i] != '\0'; i++)
+		name[i] = cmd_line[i];
+	name[i] = '\0';
+
+	pid = thread_create_joinable (name, PRI_DEFAULT, __do_spawn, &args);
+	if (pid != TID_ERROR) {
+		struct child_status *child = thread_find_child (pid);
+
+		/*
+			fork()와 마찬가지로 자식이 로드를 끝낼 때까지 fork_sema에서 대기
+			ARGS가 부모 스택에 있으므로 그동안 이 함수에서 나가면 안됨
+		*/
+		sema_down (&child->fork_sema);
+		if (child->exit_status == -1)
+			pid = TID_ERROR;
+	}
+
+	palloc_free_page (cmd_line);
+	return pid;
+}
+
+/* A thread function that loads the executable of a spawned
+ * process and starts it. */
+static void
+__do_spawn (void *aux) {
+	struct spawn_args *args = aux;
+	struct thread *current = thread_current ();
+	struct intr_frame if_;
+
+#ifdef VM
+	supplemental_page_table_init (&current->spt);
+#endif
+
+	if (!process_init ()
+			|| !duplicate_fds (args->parent, args->fds, args->fd_cnt))
+		goto error;
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	if (!load (args->cmd_line, &if_))
+		goto error;
+
+	// 여기서부터 ARGS는 쓸 수 없음 (부모가 깨어나 돌아감)
+	sema_up (&current->child_status->fork_sema);
+	do_iret (&if_);
+	NOT_REACHED ();
 
-	/* Finally, switch to the newly created process. */
-	if (succ)
-		do_iret (&if_);
 error:
-	// Project 2: System Call
-	current->exit_status = TID_ERROR;
-    sema_up(&current->fork_sema);
-    exit(TID_ERROR);
+	current->child_status->exit_status = TID_ERROR;
+	sema_up (&current->child_status->fork_sema);
+	exit (TID_ERROR);
 }
 
 /* Switch the current execution context to the f_name.
@@ -374,25 +545,26 @@ process_wait (tid_t child_tid UNUSED) {
 	 * XXX:       to add infinite loop here before
 	 * XXX:       implementing the process_wait. */
 
-	struct thread *child_thread = find_child(child_tid);
+	struct child_status *child = thread_find_child(child_tid);
 
-    if (child_thread == NULL) {
+    if (child == NULL) {
         return -1;
     }
 
 	/*
 		부모는 자식 프로세스가 종료될 때까지 대기, 정상적으로 종료 시 exit_status 반환, 아니면 -1 반환
 
-		1) wait sema down: 부모는 자식이 process_exit()에서 wait sema up할 때까지 대기
-		2) remove child elem: 부모가 exit_status를 가져올 수 있도록 자식의 페이지는 유지
-		3) free sema up: 잠들었던 자식 프로세스 깨움
-		4) 부모 프로세스의 wait() 종료 -> 자식 프로세스의 process_exit() 종료
+		1) exit sema down: 부모는 자식이 thread_exit()에서 exit sema up할 때까지 대기
+		2) 자식의 스레드 페이지는 이미 해제됨, exit_status는 child_status에 남아 있음
+		3) children 해시에서 빼고 참조를 놓음 -> 같은 tid로 두 번 wait하면 -1
 	*/
-    sema_down(&child_thread->wait_sema);
-    list_remove(&child_thread->child_elem);
-    sema_up(&child_thread->free_sema);
+    sema_down(&child->exit_sema);
+
+    int status = child->exit_status;
+    hash_delete(&thread_current()->children, &child->elem);
+    child_status_release(child);
 
-    return child_thread->exit_status;
+    return status;
 }
 
 /* Exit the process. This function is called by thread_exit (). */
@@ -404,16 +576,21 @@ process_exit (void) {
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
-	// 현재 열려있는 모든 파일을 닫음
-	for (int i = 0; i < FDCOUNT_LIMIT; i++) {
-        close(i);
-    }
+	// 현재 열려있는 모든 파일을 닫음, 커널 스레드는 fd 테이블이 없음
+	if (curr->fd_table != NULL) {
+		for (int i = 0; i < FDCOUNT_LIMIT; i++) {
+			close(i);
+		}
 
-    palloc_free_multiple(curr->fd_table, FDT_PAGES);
+		palloc_free_multiple(curr->fd_table, FDT_PAGES);
+		curr->fd_table = NULL;
+	}
 
-    sema_up(&curr->wait_sema);
     file_close(curr->running);
-    sema_down(&curr->free_sema);
+
+	// 시스템 콜 통계 해제
+	free(curr->syscall_stats);
+	curr->syscall_stats = NULL;
 
 	process_cleanup ();
 }
@@ -443,6 +620,13 @@ process_cleanup (void) {
 		pml4_activate (NULL);
 		pml4_destroy (pml4);
 	}
+
+	/* The shared frames mapped by PML4 belong to the image, so drop
+	 * it only after PML4 is gone. */
+	if (curr->image != NULL) {
+		image_release (curr->image);
+		curr->image = NULL;
+	}
 }
 
 /* Sets up the CPU for running user code in the nest thread.
@@ -511,9 +695,119 @@ struct ELF64_PHDR {
 
 static bool setup_stack (struct intr_frame *if_);
 static bool validate_segment (const struct Phdr *, struct file *);
+static bool merge_segment (struct load_seg *, const struct load_seg *);
+static bool read_elf (struct file *, const char *file_name, uint64_t *entry,
+		struct load_seg **segs, size_t *seg_cnt);
+static void exec_stats_add (size_t pages, uint64_t cycles);
 static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		uint32_t read_bytes, uint32_t zero_bytes,
 		bool writable);
+#ifndef VM
+static bool map_shared (const struct load_seg *, uint8_t *frames);
+#endif
+
+/* Reads and checks the ELF header and program headers of FILE,
+ * named FILE_NAME.  On success, stores the entry point in *ENTRY and
+ * a malloc()'d array of the PT_LOAD segments, merged where possible,
+ * in *SEGS and *SEG_CNT, and returns true.  The caller must free
+ * *SEGS, even on failure. */
+static bool
+read_elf (struct file *file, const char *file_name, uint64_t *entry,
+		struct load_seg **segs, size_t *seg_cnt) {
+	struct ELF ehdr;
+	struct Phdr *phdrs = NULL;
+	size_t phdr_size;
+	bool success = false;
+	int i;
+
+	/* Read and verify executable header. */
+	/*
+		ELF: 실행 파일, 목적 파일, 공유 라이브러리 그리고 코어 덤프를 위한 표준 파일 형식
+		해당 파일의 헤더를 체크하여 해당 형식에 적합한지를 (실행 가능한 파일인지) 확인
+	*/
+	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
+			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
+			|| ehdr.e_type != 2
+			|| ehdr.e_machine != 0x3E // amd64
+			|| ehdr.e_version != 1
+			|| ehdr.e_phentsize != sizeof (struct Phdr)
+			|| ehdr.e_phnum > 1024) {
+		printf ("load: %s: error loading executable\n", file_name);
+		goto done;
+	}
+
+	/* Read program headers. */
+	/*
+		프로그램 헤더 테이블 전체를 한 번의 I/O로 읽음 (헤더마다 seek + file_read 하지 않음)
+	*/
+	phdr_size = ehdr.e_phnum * sizeof (struct Phdr);
+	if (ehdr.e_phoff > (uint64_t) file_length (file))
+		goto done;
+	phdrs = malloc (phdr_size > 0 ? phdr_size : 1);
+	if (phdrs == NULL
+			|| file_read_at (file, phdrs, phdr_size, ehdr.e_phoff) != (off_t) phdr_size)
+		goto done;
+
+	/*
+		파일과 메모리에서 모두 바로 이어지는 세그먼트는 하나로 합쳐서 load_segment()를 한 번만 호출
+		합친 결과를 *SEGS 배열에 모아 둠
+	*/
+	*segs = malloc (ehdr.e_phnum > 0 ? ehdr.e_phnum * sizeof **segs : 1);
+	if (*segs == NULL)
+		goto done;
+
+	for (i = 0; i < ehdr.e_phnum; i++) {
+		struct Phdr *phdr = &phdrs[i];
+
+		switch (phdr->p_type) {
+			case PT_NULL:
+			case PT_NOTE:
+			case PT_PHDR:
+			case PT_STACK:
+			default:
+				/* Ignore this segment. */
+				break;
+			case PT_DYNAMIC:
+			case PT_INTERP:
+			case PT_SHLIB:
+				goto done;
+			case PT_LOAD:
+				if (validate_segment (phdr, file)) {
+					struct load_seg next;
+					uint64_t page_offset = phdr->p_vaddr & PGMASK;
+
+					next.writable = (phdr->p_flags & PF_W) != 0;
+					next.file_page = phdr->p_offset & ~PGMASK;
+					next.mem_page = phdr->p_vaddr & ~PGMASK;
+					if (phdr->p_filesz > 0) {
+						/* Normal segment.
+						 * Read initial part from disk and zero the rest. */
+						next.read_bytes = page_offset + phdr->p_filesz;
+						next.zero_bytes = (ROUND_UP (page_offset + phdr->p_memsz, PGSIZE)
+								- next.read_bytes);
+					} else {
+						/* Entirely zero.
+						 * Don't read anything from disk. */
+						next.read_bytes = 0;
+						next.zero_bytes = ROUND_UP (page_offset + phdr->p_memsz, PGSIZE);
+					}
+
+					if (*seg_cnt > 0 && merge_segment (&(*segs)[*seg_cnt - 1], &next))
+						break;
+					(*segs)[(*seg_cnt)++] = next;
+				}
+				else
+					goto done;
+				break;
+		}
+	}
+	*entry = ehdr.e_entry;
+	success = true;
+
+done:
+	free (phdrs);
+	return success;
+}
 
 /* Loads an ELF executable from FILE_NAME into the current thread.
  * Stores the executable's entry point into *RIP
@@ -528,11 +822,14 @@ static bool load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 load (const char *file_name, struct intr_frame *if_) {
 	struct thread *t = thread_current ();
-	struct ELF ehdr;
 	struct file *file = NULL;
-	off_t file_ofs;
+	struct load_seg *segs = NULL;
+	size_t seg_cnt = 0;
+	uint64_t entry = 0;
+	size_t page_cnt = 0;
 	bool success = false;
-	int i;
+	uint64_t start = rdtsc ();
+	size_t i;
 
 	/*
 		File Parsing
@@ -583,80 +880,52 @@ load (const char *file_name, struct intr_frame *if_) {
 	t->running = file;
 	file_deny_write(file);
 
-	/* Read and verify executable header. */
+#ifndef VM
 	/*
-		ELF: 실행 파일, 목적 파일, 공유 라이브러리 그리고 코어 덤프를 위한 표준 파일 형식
-		해당 파일의 헤더를 체크하여 해당 형식에 적합한지를 (실행 가능한 파일인지) 확인
+		같은 실행 파일을 이미 로드한 적이 있으면 image cache에서 파싱된 세그먼트 정보를 가져옴
+		ELF를 다시 읽고 파싱하지 않고, 읽기 전용 세그먼트는 디스크에서 다시 읽지 않고 캐시의 프레임을 공유
 	*/
-	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
-			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
-			|| ehdr.e_type != 2
-			|| ehdr.e_machine != 0x3E // amd64
-			|| ehdr.e_version != 1
-			|| ehdr.e_phentsize != sizeof (struct Phdr)
-			|| ehdr.e_phnum > 1024) {
-		printf ("load: %s: error loading executable\n", file_name);
-		goto done;
+	t->image = image_lookup (file);
+	if (t->image == NULL) {
+#endif
+		if (!read_elf (file, file_name, &entry, &segs, &seg_cnt))
+			goto done;
+#ifndef VM
+		t->image = image_create (file, entry, segs, seg_cnt);
 	}
+	if (t->image != NULL) {
+		entry = t->image->entry;
+		seg_cnt = t->image->seg_cnt;
+	}
+#endif
 
-	/* Read program headers. */
-	file_ofs = ehdr.e_phoff;
-	for (i = 0; i < ehdr.e_phnum; i++) {
-		struct Phdr phdr;
-
-		if (file_ofs < 0 || file_ofs > file_length (file))
-			goto done;
-		file_seek (file, file_ofs);
+	for (i = 0; i < seg_cnt; i++) {
+		const struct load_seg *seg;
+#ifndef VM
+		if (t->image != NULL) {
+			const struct image_seg *iseg = &t->image->segs[i];
 
-		if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
-			goto done;
-		file_ofs += sizeof phdr;
-		switch (phdr.p_type) {
-			case PT_NULL:
-			case PT_NOTE:
-			case PT_PHDR:
-			case PT_STACK:
-			default:
-				/* Ignore this segment. */
-				break;
-			case PT_DYNAMIC:
-			case PT_INTERP:
-			case PT_SHLIB:
-				goto done;
-			case PT_LOAD:
-				if (validate_segment (&phdr, file)) {
-					bool writable = (phdr.p_flags & PF_W) != 0;
-					uint64_t file_page = phdr.p_offset & ~PGMASK;
-					uint64_t mem_page = phdr.p_vaddr & ~PGMASK;
-					uint64_t page_offset = phdr.p_vaddr & PGMASK;
-					uint32_t read_bytes, zero_bytes;
-					if (phdr.p_filesz > 0) {
-						/* Normal segment.
-						 * Read initial part from disk and zero the rest. */
-						read_bytes = page_offset + phdr.p_filesz;
-						zero_bytes = (ROUND_UP (page_offset + phdr.p_memsz, PGSIZE)
-								- read_bytes);
-					} else {
-						/* Entirely zero.
-						 * Don't read anything from disk. */
-						read_bytes = 0;
-						zero_bytes = ROUND_UP (page_offset + phdr.p_memsz, PGSIZE);
-					}
-					/*
-						load_segment
-						: 커널 주소에 해당 파일을 로드함
-						: install_page()를 통해 유저 스택 페이지와 커널 주소를 매핑시킴
-
-						즉, load_segment()가 호출되면 해당 파일이 전부 커널 페이지에 올라가는 것
-					*/
-					if (!load_segment (file, file_page, (void *) mem_page,
-								read_bytes, zero_bytes, writable))
-						goto done;
-				}
-				else
+			seg = &iseg->seg;
+			if (iseg->frames != NULL) {
+				if (!map_shared (seg, iseg->frames))
 					goto done;
-				break;
-		}
+				page_cnt += (seg->read_bytes + seg->zero_bytes) / PGSIZE;
+				continue;
+			}
+		} else
+#endif
+			seg = &segs[i];
+		/*
+			load_segment
+			: 커널 주소에 해당 파일을 로드함
+			: install_page()를 통해 유저 스택 페이지와 커널 주소를 매핑시킴
+
+			즉, load_segment()가 호출되면 해당 파일이 전부 커널 페이지에 올라가는 것
+		*/
+		if (!load_segment (file, seg->file_page, (void *) seg->mem_page,
+					seg->read_bytes, seg->zero_bytes, seg->writable))
+			goto done;
+		page_cnt += (seg->read_bytes + seg->zero_bytes) / PGSIZE;
 	}
 
 	/* Set up stack. */
@@ -668,7 +937,7 @@ load (const char *file_name, struct intr_frame *if_) {
 		goto done;
 
 	/* Start address. */
-	if_->rip = ehdr.e_entry;
+	if_->rip = entry;
 
 	/* TODO: Your code goes here.
 	 * TODO: Implement argument passing (see project2/argument_passing.html). */
@@ -683,6 +952,9 @@ load (const char *file_name, struct intr_frame *if_) {
 
 done:
 	/* We arrive here whether the load is successful or not. */
+	free (segs);
+	if (success)
+		exec_stats_add (page_cnt, rdtsc () - start);
 	return success;
 }
 
@@ -731,6 +1003,69 @@ validate_segment (const struct Phdr *phdr, struct file *file) {
 	return true;
 }
 
+/* Appends NEXT to the pending run SEG if it continues SEG in memory
+ * and in the file, at the same offset between the two and with the
+ * same permissions, so that the two are read and mapped together.
+ * NEXT may also start inside SEG's last page, as the code segment
+ * does after the ELF headers with current linkers; loading those
+ * separately would map that page twice.  Returns true if merged. */
+static bool
+merge_segment (struct load_seg *seg, const struct load_seg *next) {
+	uint64_t read_end, mem_end;
+
+	if (seg->writable != next->writable
+			|| next->mem_page < seg->mem_page
+			|| next->mem_page - seg->mem_page != next->file_page - seg->file_page
+			|| next->mem_page > seg->mem_page + seg->read_bytes)
+		return false;
+
+	read_end = next->mem_page + next->read_bytes;
+	if (read_end < seg->mem_page + seg->read_bytes)
+		read_end = seg->mem_page + seg->read_bytes;
+	mem_end = next->mem_page + next->read_bytes + next->zero_bytes;
+	if (mem_end < seg->mem_page + seg->read_bytes + seg->zero_bytes)
+		mem_end = seg->mem_page + seg->read_bytes + seg->zero_bytes;
+
+	seg->read_bytes = read_end - seg->mem_page;
+	seg->zero_bytes = mem_end - read_end;
+	return true;
+}
+
+/* Exec latency, by size of the loaded image. */
+static const size_t exec_class_pages[] = {16, 128, SIZE_MAX};
+static const char *exec_class_names[] = {"<= 16", "<= 128", "> 128"};
+#define EXEC_CLASSES (sizeof exec_class_pages / sizeof *exec_class_pages)
+static long long exec_cnt[EXEC_CLASSES];
+static uint64_t exec_cycles[EXEC_CLASSES];
+static uint64_t exec_max_cycles[EXEC_CLASSES];
+
+static void
+exec_stats_add (size_t pages, uint64_t cycles) {
+	enum intr_level old_level;
+	size_t c;
+
+	for (c = 0; pages > exec_class_pages[c]; c++)
+		continue;
+	old_level = intr_disable ();
+	exec_cnt[c]++;
+	exec_cycles[c] += cycles;
+	if (cycles > exec_max_cycles[c])
+		exec_max_cycles[c] = cycles;
+	intr_set_level (old_level);
+}
+
+/* Prints exec latency statistics. */
+void
+process_print_stats (void) {
+	size_t c;
+
+	for (c = 0; c < EXEC_CLASSES; c++)
+		if (exec_cnt[c] > 0)
+			printf ("Exec: %lld loads of %s pages, %llu avg cycles, "
+					"%llu max cycles\n", exec_cnt[c], exec_class_names[c],
+					exec_cycles[c] / exec_cnt[c], exec_max_cycles[c]);
+}
+
 #ifndef VM
 /* Codes of this block will be ONLY USED DURING project 2.
  * If you want to implement the function for whole project 2, implement it
@@ -738,6 +1073,8 @@ validate_segment (const struct Phdr *phdr, struct file *file) {
 
 /* load() helpers. */
 static bool install_page (void *upage, void *kpage, bool writable);
+static bool load_segment_paged (struct file *file, off_t ofs, uint8_t *upage,
+		uint32_t read_bytes, uint32_t zero_bytes, bool writable);
 
 /* Loads a segment starting at offset OFS in FILE at address
  * UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
@@ -756,10 +1093,45 @@ static bool install_page (void *upage, void *kpage, bool writable);
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		uint32_t read_bytes, uint32_t zero_bytes, bool writable) {
+	size_t page_cnt = (read_bytes + zero_bytes) / PGSIZE;
+	size_t mapped;
+	uint8_t *kpages;
+
 	ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
+	/*
+		세그먼트 전체를 물리적으로 연속된 페이지에 한 번에 할당하면
+		파일 내용도 file_read_at() 한 번으로 읽고 (디스크 섹터가 페이지로 바로 읽힘)
+		PTE도 pml4_set_pages()로 한꺼번에 매핑할 수 있음
+		연속된 페이지가 없으면 페이지 단위로 로드
+	*/
+	kpages = get_user_pages (0, page_cnt);
+	if (kpages == NULL)
+		return load_segment_paged (file, ofs, upage, read_bytes, zero_bytes,
+				writable);
+
+	if (file_read_at (file, kpages, read_bytes, ofs) != (int) read_bytes) {
+		palloc_free_multiple (kpages, page_cnt);
+		return false;
+	}
+	memset (kpages + read_bytes, 0, zero_bytes);
+
+	mapped = pml4_set_pages (thread_current ()->pml4, upage, kpages, page_cnt,
+			writable);
+	if (mapped < page_cnt) {
+		palloc_free_multiple (kpages + mapped * PGSIZE, page_cnt - mapped);
+		return false;
+	}
+	return true;
+}
+
+/* Like load_segment(), but allocates, reads and maps one page at a
+ * time.  Used when no physically contiguous run of pages is free. */
+static bool
+load_segment_paged (struct file *file, off_t ofs, uint8_t *upage,
+		uint32_t read_bytes, uint32_t zero_bytes, bool writable) {
 	file_seek (file, ofs);
 	while (read_bytes > 0 || zero_bytes > 0) {
 		/* Do calculate how to fill this page.
@@ -769,7 +1141,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* Get a page of memory. */
-		uint8_t *kpage = palloc_get_page (PAL_USER);
+		uint8_t *kpage = get_user_pages (0, 1);
 		if (kpage == NULL)
 			return false;
 
@@ -782,7 +1154,6 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 
 		/* Add the page to the process's address space. */
 		if (!install_page (upage, kpage, writable)) {
-			printf("fail\n");
 			palloc_free_page (kpage);
 			return false;
 		}
@@ -795,13 +1166,25 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	return true;
 }
 
+/* Maps segment SEG read-only onto FRAMES, the image cache's copy of
+ * its contents, without reading the file.  The frames stay owned by
+ * the image. */
+static bool
+map_shared (const struct load_seg *seg, uint8_t *frames) {
+	size_t page_cnt = (seg->read_bytes + seg->zero_bytes) / PGSIZE;
+
+	ASSERT (!seg->writable);
+	return pml4_share_pages (thread_current ()->pml4, (void *) seg->mem_page,
+			frames, page_cnt) == page_cnt;
+}
+
 /* Create a minimal stack by mapping a zeroed page at the USER_STACK */
 static bool
 setup_stack (struct intr_frame *if_) {
 	uint8_t *kpage;
 	bool success = false;
 
-	kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+	kpage = get_user_pages (PAL_ZERO, 1);
 	if (kpage != NULL) {
 		success = install_page (((uint8_t *) USER_STACK) - PGSIZE, kpage, true);
 		if (success)
@@ -955,22 +1338,3 @@ void push_arguments(int argc, char **argv, struct intr_frame *if_) {
 	if_->R.rdi  = argc;
 	if_->R.rsi = if_->rsp + 8;
 }
-
-struct thread *find_child(int pid) {
-    struct thread *curr = thread_current();
-    struct list *child_list = &curr->child_list;
-
-    struct list_elem *e;
-
-	if (!list_empty(child_list)) {
-		for (e = list_begin(child_list); e != list_end(child_list); e = list_next(e)){
-			struct thread *t = list_entry(e, struct thread, child_elem);
-
-			if (t->tid == pid){
-				return t;
-			}
-		}
-	}
-
-    return NULL;
-}
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "userprog/syscall.h"
 #include <stdio.h>
+#include <limits.h>
+#include <io-ring.h>
 #include <syscall-nr.h>
+#include <syscall-stat.h>
+#include <uio.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
 #include "threads/loader.h"
@@ -13,16 +17,24 @@
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "threads/palloc.h"
+#include "userprog/usercopy.h"
+#include "filesys/directory.h"
+#include "threads/trace.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+#include "devices/disk.h"
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 
-void check_address (void *address);
+bool copy_in_string (char *dst, const char *usrc, size_t size);
+void check_buffer (const void *buffer, unsigned size, bool writable);
 
 void halt (void);
 void exit (int status);
 tid_t fork (const char *thread_name, struct intr_frame *f);
 int exec (const char *cmd_line);
+tid_t spawn (const char *cmd_line, const struct spawn_fd *fd_actions, size_t fd_cnt);
 int wait (tid_t pid);
 bool create (const char *file, unsigned initial_size);
 bool remove (const char *file);
@@ -33,6 +45,16 @@ int write (int fd, const void *buffer, unsigned size);
 void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
+int trace_dump (int fd);
+int clock_gettime (int clock_id, struct timespec *ts);
+int syscall_stats (int scope, struct syscall_stat *stats, int cnt);
+int io_ring_enter (struct io_ring *ring);
+int pread (int fd, void *buffer, unsigned size, off_t offset);
+int pwrite (int fd, const void *buffer, unsigned size, off_t offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+
+static void record_syscall (uint64_t nr, uint64_t rax, uint64_t cycles);
 
 struct file *find_file_by_fd(int fd);
 int add_file_to_fdt(struct file *file);
@@ -64,7 +86,7 @@ syscall_init (void) {
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
 
 	// 파일 사용 관련 Lock 초기화
-	lock_init(&file_lock);
+	lock_init_named(&file_lock, "file_lock");
 }
 
 /* The main system call interface */
@@ -78,8 +100,12 @@ syscall_init (void) {
 void
 syscall_handler (struct intr_frame *f UNUSED) {
 	// TODO: Your implementation goes here.
+	uint64_t nr = f->R.rax;
+	uint64_t start = rdtsc();
+
+	trace_event(TRACE_SYSCALL_ENTER, nr, f->R.rdi);
 
-	switch (f->R.rax) {
+	switch (nr) {
 		case SYS_HALT:
 			halt();
 			break;
@@ -138,10 +164,157 @@ syscall_handler (struct intr_frame *f UNUSED) {
 			close(f->R.rdi);
 			break;
 
+		case SYS_SPAWN:
+			f->R.rax = spawn(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+
+		case SYS_TRACE_DUMP:
+			f->R.rax = trace_dump(f->R.rdi);
+			break;
+
+		case SYS_CLOCK_GETTIME:
+			f->R.rax = clock_gettime(f->R.rdi, f->R.rsi);
+			break;
+
+		case SYS_SYSCALL_STATS:
+			f->R.rax = syscall_stats(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+
+		case SYS_IO_RING_ENTER:
+			f->R.rax = io_ring_enter(f->R.rdi);
+			break;
+
+		case SYS_PREAD:
+			f->R.rax = pread(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+
+		case SYS_PWRITE:
+			f->R.rax = pwrite(f->R.rdi, f->R.rsi, f->R.rdx, f->R.r10);
+			break;
+
+		case SYS_READV:
+			f->R.rax = readv(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+
+		case SYS_WRITEV:
+			f->R.rax = writev(f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+
 		default:
 			exit(-1);
 			break;
 	}
+
+	trace_event(TRACE_SYSCALL_EXIT, nr, f->R.rax);
+	record_syscall(nr, f->R.rax, rdtsc() - start);
+}
+
+/*
+	시스템 콜 통계
+
+	syscall_handler()가 리턴하는 모든 시스템 콜의 횟수, 실패 횟수, 걸린 사이클 (합계와 최대)을
+	시스템 전체 (syscall_totals)와 프로세스별 (thread의 syscall_stats)로 기록
+	halt할 때 print_stats()에서 시스템 전체 통계를 출력
+*/
+static struct syscall_stat syscall_totals[SYS_CNT];
+
+// syscall-entry.S가 sysretq 대신 iretq로 돌아간 횟수
+uint64_t syscall_iret_cnt;
+
+static const char *syscall_names[SYS_CNT] = {
+	[SYS_HALT] = "halt", [SYS_EXIT] = "exit", [SYS_FORK] = "fork",
+	[SYS_EXEC] = "exec", [SYS_WAIT] = "wait", [SYS_CREATE] = "create",
+	[SYS_REMOVE] = "remove", [SYS_OPEN] = "open",
+	[SYS_FILESIZE] = "filesize", [SYS_READ] = "read",
+	[SYS_WRITE] = "write", [SYS_SEEK] = "seek", [SYS_TELL] = "tell",
+	[SYS_CLOSE] = "close", [SYS_MMAP] = "mmap", [SYS_MUNMAP] = "munmap",
+	[SYS_CHDIR] = "chdir", [SYS_MKDIR] = "mkdir",
+	[SYS_READDIR] = "readdir", [SYS_ISDIR] = "isdir",
+	[SYS_INUMBER] = "inumber", [SYS_SYMLINK] = "symlink",
+	[SYS_DUP2] = "dup2", [SYS_MOUNT] = "mount", [SYS_UMOUNT] = "umount",
+	[SYS_SPAWN] = "spawn", [SYS_TRACE_DUMP] = "trace_dump",
+	[SYS_CLOCK_GETTIME] = "clock_gettime",
+	[SYS_SYSCALL_STATS] = "syscall_stats",
+	[SYS_IO_RING_ENTER] = "io_ring_enter",
+	[SYS_PREAD] = "pread",
+	[SYS_PWRITE] = "pwrite",
+	[SYS_READV] = "readv",
+	[SYS_WRITEV] = "writev",
+};
+
+// syscall_failed: 시스템 콜 nr이 rax를 리턴했을 때 실패한 것인지 판단
+static bool syscall_failed (uint64_t nr, uint64_t rax) {
+	switch (nr) {
+		// 리턴값이 없거나 실패를 알리지 않음
+		case SYS_HALT:
+		case SYS_EXIT:
+		case SYS_SEEK:
+		case SYS_TELL:
+		case SYS_CLOSE:
+		case SYS_MUNMAP:
+			return false;
+
+		// bool을 리턴: false가 실패
+		case SYS_CREATE:
+		case SYS_REMOVE:
+		case SYS_CHDIR:
+		case SYS_MKDIR:
+		case SYS_READDIR:
+		case SYS_ISDIR:
+			return (rax & 0xff) == 0;
+
+		// 주소를 리턴: NULL이 실패
+		case SYS_MMAP:
+			return rax == 0;
+
+		// int를 리턴: 음수가 실패
+		default:
+			return (int) rax < 0;
+	}
+}
+
+static void add_sample (struct syscall_stat *s, uint64_t cycles, bool failed) {
+	s->count++;
+	s->errors += failed;
+	s->cycles += cycles;
+	if (cycles > s->max_cycles) {
+		s->max_cycles = cycles;
+	}
+}
+
+// record_syscall: 시스템 콜 nr이 cycles 동안 걸려 rax를 리턴한 것을 기록
+static void record_syscall (uint64_t nr, uint64_t rax, uint64_t cycles) {
+	struct thread *curr = thread_current();
+	bool failed = syscall_failed(nr, rax);
+
+	// 프로세스별 통계는 첫 시스템 콜 때 할당, 할당에 실패하면 시스템 전체 통계만 기록
+	if (curr->syscall_stats == NULL) {
+		curr->syscall_stats = calloc(SYS_CNT, sizeof *curr->syscall_stats);
+	}
+
+	// 시스템 전체 통계는 모든 프로세스가 같이 쓰므로 인터럽트를 끄고 갱신
+	enum intr_level old_level = intr_disable();
+	add_sample(&syscall_totals[nr], cycles, failed);
+	intr_set_level(old_level);
+
+	if (curr->syscall_stats != NULL) {
+		add_sample(&curr->syscall_stats[nr], cycles, failed);
+	}
+}
+
+// syscall_print_stats: 한 번이라도 불린 시스템 콜의 시스템 전체 통계를 출력
+void syscall_print_stats (void) {
+	printf("System calls: %llu returned through iretq\n", syscall_iret_cnt);
+	for (int nr = 0; nr < SYS_CNT; nr++) {
+		struct syscall_stat *s = &syscall_totals[nr];
+
+		if (s->count == 0) {
+			continue;
+		}
+		printf("  %-14s %8llu calls %6llu errors, avg %llu max %llu cycles\n",
+				syscall_names[nr], s->count, s->errors,
+				s->cycles / s->count, s->max_cycles);
+	}
 }
 
 /*
@@ -151,12 +324,34 @@ syscall_handler (struct intr_frame *f UNUSED) {
 	2) Kernel VM을 가르키거나 (=KERNEL_BASE보다 높은 주소)
 	3) 매핑되지 않은 VM을 가르키거나 (할당되지 않은 주소)
 
-	check_address: 해당 주소가 올바른 접근인지 확인, 올바르지 않은 주소일 경우 프로세스 종료
+	포인터를 미리 페이지 테이블에서 조회하지 않고 usercopy.c의 접근 함수로 바로 읽고 씀
+	잘못된 주소면 MMU가 page fault를 내고, page_fault()가 exception table을 보고 실패로 돌려줌
+	이 경우 프로세스 종료
 */
-void check_address (void *address) {
-	struct thread *curr = thread_current();
 
-	if (address == NULL | !is_user_vaddr(address) | pml4_get_page(curr->pml4, address) == NULL) {
+/*
+	copy_in_string: 유저 문자열 usrc를 커널 버퍼 dst (size 바이트)로 복사
+
+	문자열이 size 바이트 안에 끝나지 않으면 (너무 긴 이름) false 리턴
+*/
+bool copy_in_string (char *dst, const char *usrc, size_t size) {
+	int64_t len = strncpy_from_user(dst, usrc, size);
+
+	if (len < 0) {
+		exit(-1);
+	}
+
+	return len < (int64_t) size;
+}
+
+/*
+	check_buffer: 버퍼 [buffer, buffer + size)가 걸쳐 있는 모든 페이지를 확인
+
+	read()/write()는 사용자 버퍼를 커널 버퍼 없이 파일 시스템에 그대로 넘기므로 (disk_read가 사용자 페이지에 직접 씀)
+	lock을 잡은 채 fault가 나지 않도록, 페이지마다 한 바이트씩 미리 접근해 봄 (커널이 쓸 경우 writable인지도 확인)
+*/
+void check_buffer (const void *buffer, unsigned size, bool writable) {
+	if (!probe_user(buffer, size, writable)) {
 		exit(-1);
 	}
 }
@@ -185,7 +380,14 @@ void exit (int status) {
 
 // 현재 프로세스의 복제본인 새 프로세스를 thread_name이라는 이름으로 생성
 tid_t fork (const char *thread_name, struct intr_frame *f) {
-	return process_fork(thread_name, f);
+	char name[16];
+
+	// 스레드 이름은 어차피 16바이트로 잘리므로, 긴 이름도 잘라서 사용
+	if (!copy_in_string(name, thread_name, sizeof name)) {
+		name[sizeof name - 1] = '\0';
+	}
+
+	return process_fork(name, f);
 }
 
 /*
@@ -194,14 +396,20 @@ tid_t fork (const char *thread_name, struct intr_frame *f) {
 */
 // 주어진 인수를 전달하여 현재 프로세스를 cmd_line에 지정된 이름의 실행 파일로 변경
 int exec (const char *cmd_line) {
-	check_address(cmd_line);
-
-	char *cl_copy = palloc_get_page(PAL_ZERO);
+	char *cl_copy = palloc_get_page(0);
 	if (cl_copy == NULL) {
 		exit(-1);
 	}
 
-	strlcpy (cl_copy, cmd_line, strlen(cmd_line) + 1);
+	// 복사하면서 길이를 확인하므로, 검증되지 않은 유저 메모리에 strlen()을 하지 않음
+	int64_t len = strncpy_from_user(cl_copy, cmd_line, PGSIZE);
+	if (len < 0 || len == PGSIZE) {
+		palloc_free_page(cl_copy);
+		if (len < 0) {
+			exit(-1);
+		}
+		return -1;
+	}
 
 	if (process_exec(cl_copy) == -1) {
 		return -1;
@@ -211,6 +419,45 @@ int exec (const char *cmd_line) {
 	return 0;
 }
 
+/*
+	fork() 후 exec()를 하는 대신, cmd_line을 실행하는 자식 프로세스를 바로 생성
+	fd_actions가 NULL이면 fork()처럼 모든 fd를 물려주고, 아니면 콘솔과 fd_actions에 지정된 fd만 물려줌
+	실행 파일을 로드할 수 없으면 -1 리턴
+*/
+// cmd_line을 실행하는 새 자식 프로세스를 생성, process.c의 process_spawn() 사용
+tid_t spawn (const char *cmd_line, const struct spawn_fd *fd_actions, size_t fd_cnt) {
+	struct spawn_fd fds[SPAWN_FD_MAX];
+
+	if (fd_actions != NULL) {
+		if (fd_cnt > SPAWN_FD_MAX) {
+			return TID_ERROR;
+		}
+		if (!copy_from_user(fds, fd_actions, fd_cnt * sizeof *fds)) {
+			exit(-1);
+		}
+	}
+
+	char *cl_copy = palloc_get_page(0);
+	if (cl_copy == NULL) {
+		return TID_ERROR;
+	}
+
+	int64_t len = strncpy_from_user(cl_copy, cmd_line, PGSIZE);
+	if (len < 0 || len == PGSIZE) {
+		palloc_free_page(cl_copy);
+		if (len < 0) {
+			exit(-1);
+		}
+		return TID_ERROR;
+	}
+
+	// cl_copy는 process_spawn()이 해제
+	if (fd_actions == NULL) {
+		return process_spawn(cl_copy, NULL, 0);
+	}
+	return process_spawn(cl_copy, fds, fd_cnt);
+}
+
 // 자식 프로세스가 종료될 때까지 대기하고 올바르게 종료되었는지 확인, process.c의 process_wait() 사용
 int wait (tid_t pid) {
 	return process_wait(pid);
@@ -218,16 +465,24 @@ int wait (tid_t pid) {
 
 // 초기 initial_size 바이트 크기의 file이라는 새 파일을 생성, filesys.c의 filesys_create() 사용
 bool create (const char *file, unsigned initial_size) {
-	check_address(file);
+	char name[NAME_MAX + 1];
 
-	return filesys_create(file, initial_size);
+	if (!copy_in_string(name, file, sizeof name)) {
+		return false;
+	}
+
+	return filesys_create(name, initial_size);
 }
 
 // file이라는 파일을 삭제, filesys.c의 filesys_remove() 사용
 bool remove (const char *file) {
-	check_address(file);
+	char name[NAME_MAX + 1];
+
+	if (!copy_in_string(name, file, sizeof name)) {
+		return false;
+	}
 
-	return filesys_remove(file);
+	return filesys_remove(name);
 }
 
 /*
@@ -237,13 +492,18 @@ bool remove (const char *file) {
 */
 // file이라는 파일을 오픈, filesys.c의 filesys_open() 사용, file.c의 file_close() 사용
 int open (const char *file) {
-	check_address(file);
+	char name[NAME_MAX + 1];
+
+	if (!copy_in_string(name, file, sizeof name)) {
+		return -1;
+	}
 
 	lock_acquire(&file_lock);
 
-	struct file *open_file = filesys_open(file);
+	struct file *open_file = filesys_open(name);
 
 	if (open_file == NULL) {
+		lock_release(&file_lock);
 		return -1;
 	}
 
@@ -278,7 +538,7 @@ int filesize (int fd) {
 */
 // fd로 열린 파일을 버퍼(바이트 단위)로 읽음, input.c의 input_getc() 사용, file.c의 file_read() 사용
 int read (int fd, void *buffer, unsigned size) {
-	check_address(buffer);
+	check_buffer(buffer, size, true);
 
 	struct file *file = find_file_by_fd(fd);
 	if (file == NULL) {
@@ -316,7 +576,7 @@ int read (int fd, void *buffer, unsigned size) {
 
 // fd에 size 크기(바이트 단위)의 buffer 값을 씀, file.c의 file_write() 사용
 int write (int fd, const void *buffer, unsigned size) {
-	check_address(buffer);
+	check_buffer(buffer, size, false);
 
 	struct file *file = find_file_by_fd(fd);
 	if (file == NULL) {
@@ -372,6 +632,406 @@ void close (int fd) {
 	remove_file_from_fdt(fd);
 }
 
+/*
+	커널의 이벤트 트레이스를 fd로 열린 파일에 씀, 형식은 trace-event.h 참고
+	파일은 늘어나지 않으므로 미리 충분한 크기로 create 해야 함 (안 들어가는 오래된 이벤트는 버림)
+	핀토스를 끈 뒤 pintos -g로 꺼내서 utils/pintos-trace로 분석
+	쓴 바이트 수를 리턴, 트레이스가 꺼져 있거나 fd가 파일이 아니거나 헤더도 못 쓰면 -1 리턴
+*/
+// 이벤트 트레이스를 fd에 씀, trace.c의 trace_write() 사용
+int trace_dump (int fd) {
+	struct file *file = find_file_by_fd(fd);
+
+	if (fd <= 1 || file == NULL) {
+		return -1;
+	}
+
+	lock_acquire(&file_lock);
+	int count = trace_write(file);
+	lock_release(&file_lock);
+
+	return count;
+}
+
+// 부팅 후 지난 시간을 나노초 단위로 ts에 씀, timer.c의 timer_ns() 사용 (TSC 기반)
+int clock_gettime (int clock_id, struct timespec *ts) {
+	if (clock_id != CLOCK_MONOTONIC) {
+		return -1;
+	}
+
+	int64_t ns = timer_ns();
+	struct timespec t = {
+		.tv_sec = ns / 1000000000,
+		.tv_nsec = ns % 1000000000,
+	};
+
+	if (!copy_to_user(ts, &t, sizeof t)) {
+		exit(-1);
+	}
+
+	return 0;
+}
+
+/*
+	syscall_stats: 시스템 콜 통계를 stats 배열 (cnt칸)에 복사하고 SYS_CNT를 리턴
+
+	scope가 SYSCALL_STATS_SELF면 현재 프로세스, SYSCALL_STATS_ALL이면 부팅 후 시스템 전체
+	cnt가 0이면 아무것도 복사하지 않으므로 왕복 비용만 재는 "빈" 시스템 콜로도 쓸 수 있음
+*/
+int syscall_stats (int scope, struct syscall_stat *stats, int cnt) {
+	struct syscall_stat *src;
+
+	if (scope == SYSCALL_STATS_ALL) {
+		src = syscall_totals;
+	} else if (scope == SYSCALL_STATS_SELF) {
+		src = thread_current()->syscall_stats;
+	} else {
+		return -1;
+	}
+	if (cnt < 0) {
+		return -1;
+	}
+	if (cnt > SYS_CNT) {
+		cnt = SYS_CNT;
+	}
+
+	// 한 칸씩 복사: 시스템 전체 통계는 다른 프로세스가 갱신 중일 수 있으니 인터럽트를 끄고 읽음
+	// (유저 메모리에 쓰다가 page fault가 날 수 있으므로 인터럽트를 끈 채 copy_to_user 하지 않음)
+	for (int i = 0; i < cnt; i++) {
+		struct syscall_stat s = {0};
+
+		if (src != NULL) {
+			enum intr_level old_level = intr_disable();
+			s = src[i];
+			intr_set_level(old_level);
+		}
+		if (!copy_to_user(&stats[i], &s, sizeof s)) {
+			exit(-1);
+		}
+	}
+	return SYS_CNT;
+}
+
+/*
+	I/O 링: 유저가 io_ring에 쌓아 둔 요청들을 시스템 콜 한 번에 처리 (io-ring.h 참고)
+
+	요청마다 시스템 콜을 부르면 진입/복귀, 포인터 검사, file_lock 획득/해제를 매번 해야 하지만
+	링을 쓰면 file_lock을 한 번만 잡고 요청을 차례대로 처리한 뒤 결과(completion)를 링에 써 줌
+	콘솔(fd 0, 1)은 다루지 않음
+*/
+
+// io_ring_run: 요청 하나를 처리하고 결과를 리턴, file_lock을 잡은 상태에서 호출
+static int io_ring_run (const struct io_sqe *sqe) {
+	struct file *file = NULL;
+	void *addr = (void *) sqe->addr;
+
+	// fd_table의 0, 1번 칸에는 콘솔을 뜻하는 1, 2가 들어 있으므로 진짜 파일인지도 확인
+	if (sqe->op != IO_OP_NOP && sqe->op != IO_OP_OPEN) {
+		file = find_file_by_fd(sqe->fd);
+		if (sqe->fd <= 1 || file == NULL || (uintptr_t) file <= 2) {
+			return -1;
+		}
+	}
+
+	switch (sqe->op) {
+		case IO_OP_NOP:
+			return 0;
+
+		// 잘못된 버퍼는 프로세스를 죽이지 않고 이 요청만 실패 (file_lock을 잡고 있으므로)
+		case IO_OP_READ:
+			if (!probe_user(addr, sqe->len, true)) {
+				return -1;
+			}
+			return file_read(file, addr, sqe->len);
+
+		case IO_OP_WRITE:
+			if (!probe_user(addr, sqe->len, false)) {
+				return -1;
+			}
+			return file_write(file, addr, sqe->len);
+
+		case IO_OP_SEEK:
+			file_seek(file, sqe->pos);
+			return 0;
+
+		case IO_OP_OPEN: {
+			char name[NAME_MAX + 1];
+			int64_t len = strncpy_from_user(name, addr, sizeof name);
+			if (len < 0 || len == sizeof name) {
+				return -1;
+			}
+
+			struct file *open_file = filesys_open(name);
+			if (open_file == NULL) {
+				return -1;
+			}
+
+			int fd = add_file_to_fdt(open_file);
+			if (fd == -1) {
+				file_close(open_file);
+			}
+			return fd;
+		}
+
+		case IO_OP_CLOSE:
+			remove_file_from_fdt(sqe->fd);
+			file_close(file);
+			return 0;
+
+		// 버퍼 캐시가 없어서 file_write()가 바로 디스크에 씀, 할 일 없음
+		case IO_OP_FSYNC:
+			return 0;
+
+		default:
+			return -1;
+	}
+}
+
+/*
+	io_ring_enter: ring의 SQ에 쌓인 요청을 SQ가 빌 때까지, 또는 CQ가 찰 때까지 처리
+	처리한 요청 수를 리턴, 링의 인덱스가 말이 안 되면 -1 리턴
+*/
+int io_ring_enter (struct io_ring *ring) {
+	uint32_t sq_head, sq_tail, cq_head, cq_tail;
+
+	// 필드 순서에 기대지 않도록 인덱스를 하나씩 복사
+	if (!copy_from_user(&sq_head, &ring->sq_head, sizeof sq_head)
+			|| !copy_from_user(&sq_tail, &ring->sq_tail, sizeof sq_tail)
+			|| !copy_from_user(&cq_head, &ring->cq_head, sizeof cq_head)
+			|| !copy_from_user(&cq_tail, &ring->cq_tail, sizeof cq_tail)) {
+		exit(-1);
+	}
+
+	if (sq_tail - sq_head > IO_RING_SIZE || cq_tail - cq_head > IO_RING_SIZE) {
+		return -1;
+	}
+
+	int count = 0;
+	bool fault = false;
+
+	lock_acquire(&file_lock);
+	while (sq_head != sq_tail && cq_tail - cq_head < IO_RING_SIZE) {
+		struct io_sqe sqe;
+		struct io_cqe cqe = {0};
+
+		if (!copy_from_user(&sqe, &ring->sqes[sq_head % IO_RING_SIZE], sizeof sqe)) {
+			fault = true;
+			break;
+		}
+
+		cqe.user_data = sqe.user_data;
+		cqe.res = io_ring_run(&sqe);
+
+		if (!copy_to_user(&ring->cqes[cq_tail % IO_RING_SIZE], &cqe, sizeof cqe)) {
+			fault = true;
+			break;
+		}
+		sq_head++;
+		cq_tail++;
+		count++;
+	}
+	lock_release(&file_lock);
+
+	// file_lock을 놓은 뒤에 종료해야 다른 프로세스가 멈추지 않음
+	if (fault
+			|| !copy_to_user(&ring->sq_head, &sq_head, sizeof sq_head)
+			|| !copy_to_user(&ring->cq_tail, &cq_tail, sizeof cq_tail)) {
+		exit(-1);
+	}
+
+	return count;
+}
+
+/*
+	pread, pwrite: offset 위치에서 읽고 씀, file.c의 file_read_at(), file_write_at() 사용
+
+	seek() + read()를 시스템 콜 한 번으로 줄임
+	fork()나 dup2()로 같은 file을 공유하는 쪽의 현재 위치(pos)도 건드리지 않음
+	콘솔에는 위치가 없으므로 실패
+*/
+int pread (int fd, void *buffer, unsigned size, off_t offset) {
+	check_buffer(buffer, size, true);
+
+	struct file *file = find_file_by_fd(fd);
+	if (fd <= 1 || file == NULL || (uintptr_t) file <= 2 || offset < 0) {
+		return -1;
+	}
+
+	lock_acquire(&file_lock);
+	int count = file_read_at(file, buffer, size, offset);
+	lock_release(&file_lock);
+
+	return count;
+}
+
+int pwrite (int fd, const void *buffer, unsigned size, off_t offset) {
+	check_buffer(buffer, size, false);
+
+	struct file *file = find_file_by_fd(fd);
+	if (fd <= 1 || file == NULL || (uintptr_t) file <= 2 || offset < 0) {
+		return -1;
+	}
+
+	lock_acquire(&file_lock);
+	int count = file_write_at(file, buffer, size, offset);
+	lock_release(&file_lock);
+
+	return count;
+}
+
+/*
+	readv, writev: iov 배열의 iovcnt개 버퍼를 차례대로 읽고 씀, read()/write()처럼 현재 위치부터 시작하고 위치를 옮김
+
+	버퍼마다 file_read()/file_write()를 부르면 작은 버퍼가 섹터 경계에 걸칠 때마다
+	inode_read_at()/inode_write_at()이 섹터 전체를 bounce 버퍼로 읽고 다시 써야 함
+	그래서 버퍼들을 커널 페이지 하나에 모아, 섹터 경계에 맞춘 덩어리로 file_read_at()/file_write_at()을 부름
+*/
+
+// iov_cursor: 유저의 iovec 배열에서 지금까지 옮긴 위치
+struct iov_cursor {
+	const struct iovec *uiov;   // 유저의 iovec 배열
+	int cnt;                    // 남은 iovec 수
+	struct iovec cur;           // 지금 iovec에서 남은 부분
+};
+
+/*
+	iov_copy: 커널 버퍼 buf와 cursor가 가리키는 유저 버퍼들 사이에서 size 바이트를 옮기고 cursor를 진행
+	to_user가 true면 buf -> 유저 (readv), false면 유저 -> buf (writev)
+	유저 메모리 접근에 실패하면 false 리턴
+*/
+static bool iov_copy (struct iov_cursor *c, uint8_t *buf, size_t size, bool to_user) {
+	while (size > 0) {
+		if (c->cur.iov_len == 0) {
+			if (c->cnt == 0 || !copy_from_user(&c->cur, c->uiov, sizeof c->cur)) {
+				return false;
+			}
+			c->uiov++;
+			c->cnt--;
+			continue;
+		}
+
+		size_t n = size < c->cur.iov_len ? size : c->cur.iov_len;
+		bool ok = to_user ? copy_to_user(c->cur.iov_base, buf, n)
+		                  : copy_from_user(buf, c->cur.iov_base, n);
+		if (!ok) {
+			return false;
+		}
+		c->cur.iov_base = (uint8_t *) c->cur.iov_base + n;
+		c->cur.iov_len -= n;
+		buf += n;
+		size -= n;
+	}
+	return true;
+}
+
+// rw_vec: readv()와 writev()의 공통 부분, 옮긴 바이트 수를 리턴
+static int rw_vec (int fd, const struct iovec *uiov, int iovcnt, bool writing) {
+	if (iovcnt < 0 || iovcnt > IOV_MAX) {
+		return -1;
+	}
+
+	struct file *file = find_file_by_fd(fd);
+	if (file == NULL) {
+		return -1;
+	}
+
+	// 먼저 버퍼를 모두 검사하고 전체 길이를 구함, 잘못된 버퍼면 read()/write()처럼 프로세스 종료
+	size_t total = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		struct iovec iov;
+		if (!copy_from_user(&iov, &uiov[i], sizeof iov)) {
+			exit(-1);
+		}
+		check_buffer(iov.iov_base, iov.iov_len, !writing);
+		total += iov.iov_len;
+		if (iov.iov_len > INT_MAX || total > INT_MAX) {
+			return -1;
+		}
+	}
+
+	// 콘솔은 버퍼마다 read()/write()로 처리
+	if (fd == 0 || fd == 1) {
+		int count = 0;
+		for (int i = 0; i < iovcnt; i++) {
+			struct iovec iov;
+			if (!copy_from_user(&iov, &uiov[i], sizeof iov)) {
+				exit(-1);
+			}
+			int n = writing ? write(fd, iov.iov_base, iov.iov_len)
+			                : read(fd, iov.iov_base, iov.iov_len);
+			if (n < 0) {
+				return count > 0 ? count : -1;
+			}
+			count += n;
+		}
+		return count;
+	}
+
+	if ((uintptr_t) file <= 2) {
+		return -1;
+	}
+
+	uint8_t *bounce = palloc_get_page(0);
+	if (bounce == NULL) {
+		return -1;
+	}
+
+	struct iov_cursor c = { .uiov = uiov, .cnt = iovcnt };
+	size_t left = total;
+	bool fault = false;
+
+	lock_acquire(&file_lock);
+	off_t pos = file_tell(file);
+	while (left > 0) {
+		// 첫 덩어리는 다음 섹터 경계까지 채우고, 그 다음부터는 섹터에 맞춰 한 페이지씩 옮김
+		size_t chunk = PGSIZE - pos % DISK_SECTOR_SIZE;
+		if (chunk > left) {
+			chunk = left;
+		}
+
+		off_t n;
+		if (writing) {
+			if (!iov_copy(&c, bounce, chunk, false)) {
+				fault = true;
+				break;
+			}
+			n = file_write_at(file, bounce, chunk, pos);
+		} else {
+			n = file_read_at(file, bounce, chunk, pos);
+			if (!iov_copy(&c, bounce, n, true)) {
+				fault = true;
+				break;
+			}
+		}
+		pos += n;
+		left -= n;
+
+		// 파일 끝에 닿음
+		if ((size_t) n < chunk) {
+			break;
+		}
+	}
+	file_seek(file, pos);
+	lock_release(&file_lock);
+
+	palloc_free_page(bounce);
+
+	// 검사한 뒤에 유저가 버퍼를 바꾼 경우, file_lock을 놓은 뒤에 종료
+	if (fault) {
+		exit(-1);
+	}
+
+	return total - left;
+}
+
+int readv (int fd, const struct iovec *iov, int iovcnt) {
+	return rw_vec(fd, iov, iovcnt, false);
+}
+
+int writev (int fd, const struct iovec *iov, int iovcnt) {
+	return rw_vec(fd, iov, iovcnt, true);
+}
+
 // ↓ System Call Helper Functions
 
 // find_file_by_fd: 현재 스레드가 읽고 있는 fd를 리턴하는 함수
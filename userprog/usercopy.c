@@ -0,0 +1,158 @@
+#include "userprog/usercopy.h"
+#include "threads/vaddr.h"
+
+/* One entry in the exception table: if the instruction at INSN
+   faults on a user address, page_fault() resumes at FIXUP.
+
+   Entries are emitted next to the instructions they cover by
+   EX_TABLE and collected into the __ex_table section, whose bounds
+   the linker script exports. */
+struct ex_entry {
+	uintptr_t insn;
+	uintptr_t fixup;
+};
+
+extern const struct ex_entry __start_ex_table[], __stop_ex_table[];
+
+#define EX_TABLE(INSN, FIXUP)                       \
+	".pushsection __ex_table, \"a\"\n"          \
+	".balign 8\n"                               \
+	".quad " #INSN ", " #FIXUP "\n"             \
+	".popsection\n"
+
+/* Returns true if [UADDR, UADDR + SIZE) lies entirely in user
+   space.  Kernel addresses are mapped in every page table, so they
+   must be rejected here rather than left to the MMU. */
+static inline bool
+user_range_ok (const void *uaddr, size_t size) {
+	uintptr_t start = (uintptr_t) uaddr;
+	uintptr_t end = start + size;
+	return end >= start && end <= KERN_BASE;
+}
+
+/* Reads the byte at user address UADDR into *DST.
+   Returns false if the access faulted. */
+static inline bool
+get_user (uint8_t *dst, const uint8_t *uaddr) {
+	int err = 1;
+	uint8_t byte;
+	__asm __volatile (
+			"1: movb (%[uaddr]), %[byte]\n"
+			"   movl $0, %[err]\n"
+			"2:\n"
+			EX_TABLE (1b, 2b)
+			: [err] "+r" (err), [byte] "=q" (byte)
+			: [uaddr] "r" (uaddr)
+			: "memory");
+	*dst = byte;
+	return err == 0;
+}
+
+/* Writes BYTE to user address UADDR.
+   Returns false if the access faulted. */
+static inline bool
+put_user (uint8_t *uaddr, uint8_t byte) {
+	int err = 1;
+	__asm __volatile (
+			"1: movb %[byte], (%[uaddr])\n"
+			"   movl $0, %[err]\n"
+			"2:\n"
+			EX_TABLE (1b, 2b)
+			: [err] "+r" (err)
+			: [uaddr] "r" (uaddr), [byte] "q" (byte)
+			: "memory");
+	return err == 0;
+}
+
+/* Copies SIZE bytes from SRC to DST with `rep movsb', one side of
+   which is in user space.  On a fault the CPU leaves RCX holding the
+   number of bytes still to go, so the fixup simply falls through.
+   Returns the number of bytes not copied. */
+static inline size_t
+raw_copy (void *dst, const void *src, size_t size) {
+	__asm __volatile (
+			"1: rep movsb\n"
+			"2:\n"
+			EX_TABLE (1b, 2b)
+			: "+c" (size), "+D" (dst), "+S" (src)
+			:
+			: "memory");
+	return size;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel buffer DST.
+   Returns true if successful, false if any part of the source is
+   not readable user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size) {
+	if (!user_range_ok (usrc, size))
+		return false;
+	return raw_copy (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel buffer SRC to user address UDST.
+   Returns true if successful, false if any part of the destination
+   is not writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size) {
+	if (!user_range_ok (udst, size))
+		return false;
+	return raw_copy (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated user string USRC into DST, which has
+   room for SIZE bytes.  Returns the length of the string, not
+   counting the null terminator, or -1 if the string runs into
+   memory that is not readable by the user.  If no null terminator
+   is found within SIZE bytes, DST is not terminated and SIZE is
+   returned, so callers should treat a return value of SIZE as
+   "too long". */
+int64_t
+strncpy_from_user (char *dst, const char *usrc, size_t size) {
+	const uint8_t *src = (const uint8_t *) usrc;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		if (!is_user_vaddr (src + i) || !get_user ((uint8_t *) dst + i, src + i))
+			return -1;
+		if (dst[i] == '\0')
+			return i;
+	}
+	return size;
+}
+
+/* Checks that every page spanned by user buffer [UBUF, UBUF + SIZE)
+   can be read, and written too if WRITE is true, by touching one
+   byte per page.  Used where the kernel hands a user buffer to code
+   that cannot tolerate a fault midway, e.g. a disk transfer done
+   with locks held.  Writable probes store back the byte they read,
+   which is safe because user processes are single-threaded. */
+bool
+probe_user (const void *ubuf, size_t size, bool write) {
+	uint8_t *start = pg_round_down (ubuf);
+	uint8_t *end = (uint8_t *) ubuf + size;
+	uint8_t *p;
+
+	if (!user_range_ok (ubuf, size))
+		return false;
+	for (p = start; p < end; p += PGSIZE) {
+		uint8_t *addr = p < (uint8_t *) ubuf ? (uint8_t *) ubuf : p;
+		uint8_t byte;
+
+		if (!get_user (&byte, addr) || (write && !put_user (addr, byte)))
+			return false;
+	}
+	return true;
+}
+
+/* Returns the recovery address for a fault at kernel instruction
+   RIP, or 0 if RIP is not a user memory accessor. */
+uintptr_t
+search_exception_table (uintptr_t rip) {
+	const struct ex_entry *e;
+
+	for (e = __start_ex_table; e < __stop_ex_table; e++)
+		if (e->insn == rip)
+			return e->fixup;
+	return 0;
+}